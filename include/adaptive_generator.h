@@ -0,0 +1,186 @@
+#pragma once
+#include <iostream>
+#include <random>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include <Eigen/Dense>
+
+#include <ode_data_generator.h>
+
+namespace ode{
+
+// drop in replacement for data_generator which spends trajectories where the model is worst.
+// state space [-limit, limit]^dim is cut into a uniform grid holding a moving average of the
+// loss of trajectories started in each cell. initial conditions are drawn from the cells inside
+// the current domain in proportion to that loss (mixed with a uniform floor), and gradients are
+// scaled by p_uniform / p_sampled so the expected gradient is the one of uniform sampling.
+// the domain only grows once the loss in the current domain has stopped moving.
+template<typename Config>
+struct adaptive_generator{
+  using config_type = Config;
+  using real_type = typename Config::real_type;
+  static constexpr int dim = Config::dim;
+  static constexpr int input_dim = dim;
+  static constexpr int output_dim = dim;
+  Config c;
+
+  std::mt19937 generator{std::random_device()()};
+  std::uniform_real_distribution<real_type> distribution{-0.01, 0.01};
+
+  size_t cells_per_axis{8};
+  real_type limit{6.0};
+  real_type smoothing{0.2};
+  real_type exploration{0.1};
+  real_type max_weight{10.0};
+  real_type tolerance{0.05};
+  size_t min_reports{50};
+
+  std::vector<real_type> cell_loss{}; // negative until the cell is visited
+  size_t last_cell{0};
+  real_type weight{1.0};
+
+  real_type fast{0.0};
+  real_type slow{0.0};
+  size_t reports{0};
+  size_t total_reports{0};
+  bool grow_pending{false};
+
+  real_type cell_width() const { return real_type{2.0} * limit / static_cast<real_type>(cells_per_axis); }
+
+  size_t cell_count() const {
+    size_t result{1};
+    for(int k{0}; k < dim; ++k){ result *= cells_per_axis; }
+    return result;
+  }
+
+  // per axis extent of cell `index` clipped to the current domain, empty if it does not overlap.
+  std::pair<real_type, real_type> clipped(const size_t index, const int axis) const {
+    size_t coord = index;
+    for(int k{0}; k < axis; ++k){ coord /= cells_per_axis; }
+    coord %= cells_per_axis;
+    const real_type lo = -limit + cell_width() * static_cast<real_type>(coord);
+    return std::make_pair(std::max(lo, distribution.min()), std::min(lo + cell_width(), distribution.max()));
+  }
+
+  real_type overlap(const size_t index) const {
+    real_type result{1.0};
+    for(int k{0}; k < dim; ++k){
+      const auto[lo, hi] = clipped(index, k);
+      result *= std::max(real_type{0.0}, hi - lo) / (distribution.max() - distribution.min());
+    }
+    return result;
+  }
+
+  void grow(){
+    constexpr real_type growth_factor = 1.5;
+    if(distribution.max() < 4.0){
+      const real_type min = distribution.min() * growth_factor;
+      const real_type max = distribution.max() * growth_factor;
+      distribution = decltype(distribution)(min, max);
+    }
+    reports = 0;
+    grow_pending = false;
+  }
+
+  bool converged() const {
+    return reports >= min_reports && std::abs(fast - slow) <= tolerance * slow;
+  }
+
+  void grow_domain(){
+    if(total_reports == 0 || converged()){ grow(); }
+    else{ grow_pending = true; }
+  }
+
+  real_type dt() const { return c.dt; }
+
+  template<typename T>
+  T gradient(const T& true_, const T& pred_) const {
+    return (2.0 * weight * (pred_ - true_)).eval() * dt();
+  }
+
+  template<typename T>
+  real_type error(const T& true_, const T& pred_) const {
+    return ((pred_ - true_).eval()).squaredNorm();
+  }
+
+  trajectory<Config> get_trajectory(){
+    real_type known_max{0.0};
+    for(const auto& loss : cell_loss){ known_max = std::max(known_max, loss); }
+    const real_type unvisited = known_max > 0.0 ? known_max : real_type{1.0};
+
+    std::vector<size_t> active{};
+    std::vector<real_type> volume{};
+    std::vector<real_type> mass{};
+    real_type total_mass{0.0};
+    for(size_t i{0}; i < cell_count(); ++i){
+      const real_type v = overlap(i);
+      if(v <= 0.0){ continue; }
+      const real_type loss = cell_loss[i] < 0.0 ? unvisited : cell_loss[i];
+      active.push_back(i);
+      volume.push_back(v);
+      mass.push_back(v * loss);
+      total_mass += v * loss;
+    }
+
+    std::vector<real_type> probability(active.size());
+    for(size_t j{0}; j < active.size(); ++j){
+      const real_type guided = total_mass > 0.0 ? mass[j] / total_mass : volume[j];
+      probability[j] = (real_type{1.0} - exploration) * guided + exploration * volume[j];
+    }
+    const size_t pick = std::discrete_distribution<size_t>(probability.begin(), probability.end())(generator);
+    last_cell = active[pick];
+    weight = std::min(max_weight, volume[pick] / probability[pick]);
+
+    Matrix<real_type, Config::dim, 1> X{};
+    for(int k{0}; k < dim; ++k){
+      const auto[lo, hi] = clipped(last_cell, k);
+      X(k) = std::uniform_real_distribution<real_type>(lo, hi)(generator);
+    }
+    return trajectory<Config>(c, X);
+  }
+
+  void report(const real_type& err){
+    real_type& loss = cell_loss[last_cell];
+    loss = loss < 0.0 ? err : (real_type{1.0} - smoothing) * loss + smoothing * err;
+    fast = reports == 0 ? err : real_type{0.9} * fast + real_type{0.1} * err;
+    slow = reports == 0 ? err : real_type{0.99} * slow + real_type{0.01} * err;
+    ++reports;
+    ++total_reports;
+    if(grow_pending && converged()){ grow(); }
+  }
+
+  adaptive_generator(Config c_, size_t cells_per_axis_=8) : c{c_}, cells_per_axis{cells_per_axis_} {
+    cell_loss.assign(cell_count(), real_type{-1.0});
+  }
+};
+
+template<typename Config>
+std::ostream& operator<<(std::ostream& os, const adaptive_generator<Config>& d){
+  os << "domain " << d.distribution.min() << ' ' << d.distribution.max() << '\n';
+  os << "generator " << d.generator << '\n';
+  os << "convergence " << d.fast << ' ' << d.slow << ' ' << d.reports << ' ' << d.total_reports << ' ' << d.grow_pending << '\n';
+  os << "cells " << d.cell_loss.size();
+  for(const auto& loss : d.cell_loss){ os << ' ' << loss; }
+  os << '\n';
+  return os;
+}
+
+template<typename Config>
+std::istream& operator>>(std::istream& is, adaptive_generator<Config>& d){
+  std::string key{};
+  typename Config::real_type min{}, max{};
+  is >> key >> min >> max; assert((key == "domain"));
+  d.distribution = decltype(d.distribution)(min, max);
+  is >> key >> d.generator; assert((key == "generator"));
+  is >> key >> d.fast >> d.slow >> d.reports >> d.total_reports >> d.grow_pending; assert((key == "convergence"));
+  size_t count{0};
+  is >> key >> count; assert((key == "cells" && count == d.cell_loss.size()));
+  for(auto& loss : d.cell_loss){ is >> loss; }
+  return is;
+}
+
+}
@@ -0,0 +1,220 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace checkpoint{
+
+namespace fs = std::filesystem;
+
+// snapshots a trainer (anything with an update_count and stream operators) and writes it
+// from a background thread: state -> prefix_<update_count>.txt.tmp -> atomic rename.
+// only the newest `keep` checkpoints are retained on disk.
+// every file ends with an `end` line, so a torn write is recognised on load.
+constexpr const char* trailer = "end";
+
+// flushes a file (or directory entry) to stable storage, false on failure.
+inline bool sync_path(const fs::path& path){
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0){ return false; }
+  const bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+  return synced;
+}
+
+// a trainer checkpointed together with state that lives beside it (e.g. validate::progress).
+template<typename T, typename E>
+struct bundle{
+  using info = typename T::info;
+  T primary;
+  E extra;
+  size_t update_count;
+
+  bundle(const T& primary_, const E& extra_) : primary{primary_}, extra{extra_}, update_count{primary_.update_count} {}
+};
+
+template<typename T, typename E>
+std::ostream& operator<<(std::ostream& os, const bundle<T, E>& b){
+  os << b.primary << b.extra;
+  return os;
+}
+
+template<typename T, typename E>
+std::istream& operator>>(std::istream& is, bundle<T, E>& b){
+  is >> b.primary >> b.extra;
+  b.update_count = b.primary.update_count;
+  return is;
+}
+
+template<typename T>
+struct manager{
+  fs::path directory;
+  std::string prefix;
+  size_t keep;
+
+  std::mutex mutex{};
+  std::condition_variable cv{};
+  std::deque<T> pending{};
+  bool writing{false};
+  bool stopping{false};
+  std::vector<std::pair<size_t, fs::path>> retained{};
+  std::thread worker{};
+
+  fs::path path_for(const size_t step) const {
+    return directory / (prefix + "_" + std::to_string(step) + ".txt");
+  }
+
+  std::optional<size_t> step_of(const fs::path& path) const {
+    const std::string name = path.filename().string();
+    const std::string head = prefix + "_";
+    const std::string tail = ".txt";
+    if(name.size() <= head.size() + tail.size()){ return std::nullopt; }
+    if(name.compare(0, head.size(), head) != 0){ return std::nullopt; }
+    if(name.compare(name.size() - tail.size(), tail.size(), tail) != 0){ return std::nullopt; }
+    const std::string digits = name.substr(head.size(), name.size() - head.size() - tail.size());
+    if(!std::all_of(digits.begin(), digits.end(), [](const char c){ return c >= '0' && c <= '9'; })){ return std::nullopt; }
+    return std::stoull(digits);
+  }
+
+  // checkpoints currently on disk, oldest first.
+  std::vector<std::pair<size_t, fs::path>> list() const {
+    std::vector<std::pair<size_t, fs::path>> result{};
+    if(!fs::is_directory(directory)){ return result; }
+    for(const auto& entry : fs::directory_iterator(directory)){
+      if(const auto step = step_of(entry.path()); entry.is_regular_file() && step.has_value()){
+        result.emplace_back(*step, entry.path());
+      }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  void write(const T& state){
+    const fs::path final_path = path_for(state.update_count);
+    const fs::path tmp_path = final_path.string() + ".tmp";
+    {
+      std::ofstream out(tmp_path, std::ios::trunc);
+      out.precision(std::numeric_limits<typename T::info::real_type>::max_digits10);
+      out << state << trailer << '\n';
+      out.close();
+      if(!out || !sync_path(tmp_path)){
+        std::cerr << "checkpoint: failed to write " << tmp_path << std::endl;
+        std::error_code ec{}; fs::remove(tmp_path, ec);
+        return;
+      }
+    }
+    std::error_code ec{};
+    fs::rename(tmp_path, final_path, ec);
+    if(ec){
+      std::cerr << "checkpoint: failed to rename " << tmp_path << ": " << ec.message() << std::endl;
+      fs::remove(tmp_path, ec);
+      return;
+    }
+    // makes the rename itself durable.
+    sync_path(directory);
+
+    retained.erase(std::remove_if(retained.begin(), retained.end(), [&final_path](const auto& r){
+      return r.second == final_path;
+    }), retained.end());
+    retained.emplace_back(state.update_count, final_path);
+    std::sort(retained.begin(), retained.end());
+    while(retained.size() > keep){
+      fs::remove(retained.front().second, ec);
+      retained.erase(retained.begin());
+    }
+  }
+
+  void run(){
+    std::unique_lock<std::mutex> lock(mutex);
+    for(;;){
+      cv.wait(lock, [this]{ return stopping || !pending.empty(); });
+      if(pending.empty()){ return; }
+      T state = std::move(pending.front());
+      pending.pop_front();
+      writing = true;
+      lock.unlock();
+      write(state);
+      lock.lock();
+      writing = false;
+      cv.notify_all();
+    }
+  }
+
+  // copies the state and returns immediately; serialisation happens on the worker thread.
+  // if the writer falls behind, the oldest unwritten snapshots are dropped.
+  void save(const T& state){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending.push_back(state);
+      while(pending.size() > std::max<size_t>(keep, 1)){ pending.pop_front(); }
+    }
+    cv.notify_all();
+  }
+
+  // blocks until every queued snapshot is on disk.
+  void flush(){
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]{ return pending.empty() && !writing; });
+  }
+
+  // reads a checkpoint into state, leaving state untouched if the file is incomplete or unreadable.
+  static bool load(T& state, const fs::path& path){
+    std::ifstream file(path);
+    std::stringstream buffer{}; buffer << file.rdbuf();
+    const std::string text = buffer.str();
+    const std::string tail = std::string(trailer) + "\n";
+    if(!file || text.size() < tail.size() || text.compare(text.size() - tail.size(), tail.size(), tail) != 0){ return false; }
+    std::istringstream in(text);
+    T candidate = state;
+    std::string key{};
+    in >> candidate >> key;
+    if(!in || key != trailer){ return false; }
+    state = std::move(candidate);
+    return true;
+  }
+
+  // restores the newest readable checkpoint, returns false if there is none.
+  bool load_latest(T& state) const {
+    const auto found = list();
+    for(auto iter = found.rbegin(); iter != found.rend(); ++iter){
+      if(load(state, iter -> second)){ return true; }
+      std::cerr << "checkpoint: skipping unreadable " << iter -> second << std::endl;
+    }
+    return false;
+  }
+
+  manager(const fs::path& directory_, const std::string& prefix_, size_t keep_=3) :
+    directory{directory_}, prefix{prefix_}, keep{keep_}
+  {
+    fs::create_directories(directory);
+    retained = list();
+    worker = std::thread([this]{ run(); });
+  }
+
+  manager(const manager&) = delete;
+  manager& operator=(const manager&) = delete;
+
+  ~manager(){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+    worker.join();
+  }
+};
+
+}
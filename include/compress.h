@@ -0,0 +1,134 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+
+#include <util.h>
+#include <model.h>
+#include <ode_data_generator.h>
+
+namespace compress{
+
+template<typename T>
+using vec_t = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+// first and second moments of every latent unit and of both factors of the quadratic term,
+// gathered on teacher forced trajectories exactly as the trainer sees them.
+template<typename T>
+struct unit_statistics{
+  vec_t<T> mean;
+  vec_t<T> rms;
+  vec_t<T> left_rms;  // rms of (m_latent_1 * x)
+  vec_t<T> right_rms; // rms of (m_latent_2 * x)
+};
+
+template<typename M, typename Config>
+unit_statistics<typename M::info::real_type> collect(const M& model, const std::vector<ode::trajectory<Config>>& trajectories){
+  using T = typename M::info::real_type;
+  const Eigen::Index latent_dim = model.dims().latent;
+  vec_t<T> sum = vec_t<T>::Zero(latent_dim);
+  vec_t<T> sum_sq = vec_t<T>::Zero(latent_dim);
+  vec_t<T> left_sq = vec_t<T>::Zero(latent_dim);
+  vec_t<T> right_sq = vec_t<T>::Zero(latent_dim);
+  size_t count{0};
+  for(const auto& trajectory : trajectories){
+    typename M::info::latent_vec_t latent = M::info::latent_vec_t::Zero(latent_dim);
+    for(auto&&[input, _] : trajectory){
+      (void)_;
+      sum += latent;
+      sum_sq += latent.cwiseAbs2();
+      left_sq += (model.w.m_latent_1 * latent).cwiseAbs2();
+      right_sq += (model.w.m_latent_2 * latent).cwiseAbs2();
+      ++count;
+      const auto[out, next_latent] = model.forward(typename M::backward_t(input, latent));
+      (void)out;
+      latent = next_latent;
+    }
+  }
+  const T n = static_cast<T>(std::max<size_t>(count, 1));
+  return unit_statistics<T>{sum / n, (sum_sq / n).cwiseSqrt(), (left_sq / n).cwiseSqrt(), (right_sq / n).cwiseSqrt()};
+}
+
+// how much each unit moves everything other than itself: the output, the other units through
+// m_latent, and the quadratic term through either factor. scaled by the unit's typical size.
+template<typename W, typename T>
+vec_t<T> scores(const W& w, const unit_statistics<T>& stats){
+  const Eigen::Index latent_dim = w.m_latent.rows();
+  vec_t<T> result(latent_dim);
+  for(Eigen::Index j{0}; j < latent_dim; ++j){
+    vec_t<T> latent_col = w.m_latent.col(j);
+    latent_col(j) = T{0.0};
+    const T reach =
+      w.m_out.col(j).norm() +
+      latent_col.norm() +
+      w.m_latent_1.col(j).cwiseProduct(stats.right_rms).norm() +
+      w.m_latent_2.col(j).cwiseProduct(stats.left_rms).norm();
+    result(j) = stats.rms(j) * reach;
+  }
+  return result;
+}
+
+// indices of the `keep` highest scoring units, in their original order.
+template<typename T>
+std::vector<Eigen::Index> select(const vec_t<T>& s, const Eigen::Index keep){
+  std::vector<Eigen::Index> order(s.size());
+  std::iota(order.begin(), order.end(), Eigen::Index{0});
+  std::stable_sort(order.begin(), order.end(), [&s](const auto a, const auto b){ return s(a) > s(b); });
+  order.resize(std::min<size_t>(order.size(), static_cast<size_t>(std::max<Eigen::Index>(keep, 0))));
+  std::sort(order.begin(), order.end());
+  return order;
+}
+
+// drops every unit not in `kept`, freezing it at its mean. a constant unit is folded exactly:
+// its linear effects land in b_out / b_in, and through the quadratic term
+// (A x + a) . (B x + b) = A x . B x + diag(a) B x + diag(b) A x + a . b
+// it becomes part of m_latent and b_in.
+template<typename I>
+dyn::model<util::dynamic_info<typename I::real_type>> prune(const dyn::model<I>& m, const unit_statistics<typename I::real_type>& stats, const std::vector<Eigen::Index>& kept){
+  using T = typename I::real_type;
+  const util::dims full = m.dims();
+  std::vector<Eigen::Index> removed{};
+  for(Eigen::Index j{0}, k{0}; j < full.latent; ++j){
+    if(k < static_cast<Eigen::Index>(kept.size()) && kept[k] == j){ ++k; }
+    else{ removed.push_back(j); }
+  }
+
+  const auto n = static_cast<Eigen::Index>(kept.size());
+  const auto r = static_cast<Eigen::Index>(removed.size());
+  dyn::model<util::dynamic_info<T>> result(util::dims{full.input, full.output, n}, m.dt);
+
+  vec_t<T> frozen(r);
+  for(Eigen::Index i{0}; i < r; ++i){ frozen(i) = stats.mean(removed[i]); }
+
+  const auto rows_cols = [](const auto& mat, const std::vector<Eigen::Index>& rows, const std::vector<Eigen::Index>& cols){
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> sub(rows.size(), cols.size());
+    for(size_t i{0}; i < rows.size(); ++i){
+      for(size_t j{0}; j < cols.size(); ++j){ sub(i, j) = mat(rows[i], cols[j]); }
+    }
+    return sub;
+  };
+  std::vector<Eigen::Index> outputs(full.output);
+  std::iota(outputs.begin(), outputs.end(), Eigen::Index{0});
+  std::vector<Eigen::Index> inputs(full.input);
+  std::iota(inputs.begin(), inputs.end(), Eigen::Index{0});
+
+  const vec_t<T> left_const = rows_cols(m.w.m_latent_1, kept, removed) * frozen;
+  const vec_t<T> right_const = rows_cols(m.w.m_latent_2, kept, removed) * frozen;
+  const auto left_kept = rows_cols(m.w.m_latent_1, kept, kept);
+  const auto right_kept = rows_cols(m.w.m_latent_2, kept, kept);
+
+  result.w.m_out = rows_cols(m.w.m_out, outputs, kept);
+  result.w.b_out = m.w.b_out + rows_cols(m.w.m_out, outputs, removed) * frozen;
+  result.w.m_through = m.w.m_through;
+  result.w.m_in = rows_cols(m.w.m_in, kept, inputs);
+  result.w.b_in = rows_cols(m.w.b_in, kept, std::vector<Eigen::Index>{0});
+  result.w.b_in += rows_cols(m.w.m_latent, kept, removed) * frozen + left_const.cwiseProduct(right_const);
+  result.w.m_latent = rows_cols(m.w.m_latent, kept, kept) + left_const.asDiagonal() * right_kept + right_const.asDiagonal() * left_kept;
+  result.w.m_latent_1 = left_kept;
+  result.w.m_latent_2 = right_kept;
+  return result;
+}
+
+}
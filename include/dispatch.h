@@ -0,0 +1,100 @@
+#pragma once
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+
+#include <util.h>
+#include <model.h>
+
+namespace dyn{
+
+template<int Input, int Output, int Latent>
+struct shape{
+  template<typename T>
+  using info = util::info<T, Input, Output, Latent>;
+
+  static bool matches(const util::dims& d){
+    return d == util::dims{Input, Output, Latent};
+  }
+};
+
+template<typename ... Shapes>
+struct shape_list{};
+
+// sizes with a precompiled fixed size specialisation, everything else takes the dynamic path.
+using common_shapes = shape_list<
+  shape<2, 2, 6>, shape<2, 2, 8>, shape<2, 2, 16>,
+  shape<3, 3, 6>, shape<3, 3, 8>, shape<3, 3, 16>
+>;
+
+// recovers the dimensions of a saved model from the shape of its weight blocks
+// (m_out is output x latent, m_through is output x input). throws std::runtime_error if the
+// stream does not hold a model.
+inline util::dims read_dims(std::istream& is){
+  util::dims result{0, 0, 0};
+  const weight_names names{};
+  auto read_block = [&is](const std::string_view& name){
+    std::string line{};
+    if(!std::getline(is, line) || line != name){
+      throw std::runtime_error("model: expected block " + std::string(name) + ", found '" + line + "'");
+    }
+    Eigen::Index rows{0}, cols{0};
+    while(std::getline(is, line) && !line.empty()){
+      if(rows == 0){
+        std::istringstream ss(line);
+        std::string val{};
+        while(ss >> val){ ++cols; }
+      }
+      ++rows;
+    }
+    return std::make_pair(rows, cols);
+  };
+  const auto[out_rows, out_cols] = read_block(names.m_out);
+  read_block(names.b_out);
+  const auto[through_rows, through_cols] = read_block(names.m_through);
+  (void)through_rows;
+  result.output = out_rows;
+  result.latent = out_cols;
+  result.input = through_cols;
+  if(result.input <= 0 || result.output <= 0 || result.latent <= 0){
+    throw std::runtime_error("model: empty weight blocks");
+  }
+  return result;
+}
+
+template<typename I>
+model<util::dynamic_info<typename I::real_type>> to_dynamic(const model<I>& m){
+  model<util::dynamic_info<typename I::real_type>> result(m.dims(), m.dt);
+  over_weights([](auto& dst, const auto& src){ dst = src; }, result.w, m.w);
+  return result;
+}
+
+// loads a model of any size and hands it to f as a dyn::model<I>. f is instantiated once per
+// shape in the list plus once for the dynamic fallback; returns true if a fixed shape matched.
+// throws std::runtime_error if the stream is unreadable or does not hold a model.
+template<typename T, typename ... Shapes, typename F>
+bool load_model(std::istream& is, const T& dt, shape_list<Shapes...>, F&& f){
+  if(!is){ throw std::runtime_error("model: stream is not readable"); }
+  std::stringstream buffer{}; buffer << is.rdbuf();
+  const std::string text = buffer.str();
+  std::istringstream probe(text);
+  const util::dims d = read_dims(probe);
+
+  auto run = [&](auto m){
+    std::istringstream in(text);
+    in >> m;
+    f(m);
+  };
+
+  const bool matched = (... || (Shapes::matches(d) ? (run(model<typename Shapes::template info<T>>(dt)), true) : false));
+  if(!matched){ run(model<util::dynamic_info<T>>(d, dt)); }
+  return matched;
+}
+
+template<typename T, typename F>
+bool load_model(std::istream& is, const T& dt, F&& f){
+  return load_model(is, dt, common_shapes{}, std::forward<F>(f));
+}
+
+}
@@ -0,0 +1,409 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <posix.h>
+#include <model.h>
+#include <train.h>
+#include <ode_data_generator.h>
+
+namespace dist{
+
+// ranks form a ring: every rank only ever sends to rank + 1 and receives from rank - 1.
+// implementations provide non-blocking partial transfers, exchange() drives both directions at
+// once so that a ring of blocking sends can never deadlock on full buffers.
+struct transport{
+  size_t rank;
+  size_t world;
+
+  virtual size_t try_send(const char* data, size_t n) = 0;
+  virtual size_t try_recv(char* data, size_t n) = 0;
+
+  void exchange(const char* out, const size_t out_n, char* in, const size_t in_n){
+    size_t sent{0}, received{0};
+    while(sent < out_n || received < in_n){
+      size_t progress{0};
+      if(sent < out_n){
+        const size_t n = try_send(out + sent, out_n - sent);
+        sent += n; progress += n;
+      }
+      if(received < in_n){
+        const size_t n = try_recv(in + received, in_n - received);
+        received += n; progress += n;
+      }
+      if(progress == 0){ std::this_thread::yield(); }
+    }
+  }
+
+  void send(const char* out, const size_t n){ exchange(out, n, nullptr, 0); }
+  void recv(char* in, const size_t n){ exchange(nullptr, 0, in, n); }
+
+  size_t next() const { return (rank + 1) % world; }
+  size_t prev() const { return (rank + world - 1) % world; }
+
+  transport(size_t rank_, size_t world_) : rank{rank_}, world{world_} {}
+  transport(const transport&) = delete;
+  transport& operator=(const transport&) = delete;
+  virtual ~transport() = default;
+};
+
+struct tcp_transport : transport{
+  int listener{-1};
+  int to_next{-1};
+  int from_prev{-1};
+
+  size_t try_send(const char* data, size_t n) override {
+    const ssize_t result = ::send(to_next, data, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if(result < 0){
+      if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR){ return 0; }
+      throw util::system_error("tcp send");
+    }
+    return static_cast<size_t>(result);
+  }
+
+  size_t try_recv(char* data, size_t n) override {
+    const ssize_t result = ::recv(from_prev, data, n, MSG_DONTWAIT);
+    if(result < 0){
+      if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR){ return 0; }
+      throw util::system_error("tcp recv");
+    }
+    if(result == 0){ throw std::runtime_error("tcp recv: peer closed the connection"); }
+    return static_cast<size_t>(result);
+  }
+
+  // hosts[i] is where rank i listens on base_port + i.
+  tcp_transport(size_t rank_, size_t world_, const std::vector<std::string>& hosts, uint16_t base_port) : transport(rank_, world_) {
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    if(listener < 0){ throw util::system_error("tcp socket"); }
+    const int enable{1};
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(base_port + rank));
+    if(::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0){ throw util::system_error("tcp bind"); }
+    if(::listen(listener, 4) < 0){ throw util::system_error("tcp listen"); }
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* peer{nullptr};
+    const std::string port = std::to_string(base_port + next());
+    if(::getaddrinfo(hosts.at(next()).c_str(), port.c_str(), &hints, &peer) != 0){
+      throw std::runtime_error("tcp: cannot resolve " + hosts.at(next()));
+    }
+    // the next rank may not be listening yet.
+    for(;;){
+      to_next = ::socket(AF_INET, SOCK_STREAM, 0);
+      if(::connect(to_next, peer -> ai_addr, peer -> ai_addrlen) == 0){ break; }
+      ::close(to_next);
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ::freeaddrinfo(peer);
+    ::setsockopt(to_next, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    from_prev = ::accept(listener, nullptr, nullptr);
+    if(from_prev < 0){ throw util::system_error("tcp accept"); }
+    ::setsockopt(from_prev, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  }
+
+  ~tcp_transport() override {
+    if(to_next >= 0){ ::close(to_next); }
+    if(from_prev >= 0){ ::close(from_prev); }
+    if(listener >= 0){ ::close(listener); }
+  }
+};
+
+// single producer / single consumer byte ring living in a POSIX shared memory segment.
+struct shm_channel{
+  static constexpr uint64_t ready_magic = 0x64796e2d72696e67ull;
+  std::atomic<uint64_t> ready;
+  uint64_t capacity;
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+  alignas(64) char data[1];
+
+  static size_t bytes(const size_t capacity){ return offsetof(shm_channel, data) + capacity; }
+};
+
+// every rank owns the channel it reads from ("<session>_<rank>") and maps the one of the next
+// rank. the session name must be unique per run so stale segments are never picked up.
+struct shm_transport : transport{
+  std::string inbound_name;
+  size_t capacity;
+  shm_channel* inbound{nullptr};
+  shm_channel* outbound{nullptr};
+
+  static shm_channel* map(const int fd, const size_t capacity){
+    void* address = ::mmap(nullptr, shm_channel::bytes(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(address == MAP_FAILED){ throw util::system_error("shm mmap"); }
+    return static_cast<shm_channel*>(address);
+  }
+
+  size_t try_send(const char* src, size_t n) override {
+    const uint64_t head = outbound -> head.load(std::memory_order_relaxed);
+    const uint64_t tail = outbound -> tail.load(std::memory_order_acquire);
+    const size_t count = std::min<size_t>(n, capacity - (head - tail));
+    const size_t offset = head % capacity;
+    const size_t first = std::min(count, capacity - offset);
+    std::memcpy(outbound -> data + offset, src, first);
+    std::memcpy(outbound -> data, src + first, count - first);
+    outbound -> head.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  size_t try_recv(char* dst, size_t n) override {
+    const uint64_t tail = inbound -> tail.load(std::memory_order_relaxed);
+    const uint64_t head = inbound -> head.load(std::memory_order_acquire);
+    const size_t count = std::min<size_t>(n, head - tail);
+    const size_t offset = tail % capacity;
+    const size_t first = std::min(count, capacity - offset);
+    std::memcpy(dst, inbound -> data + offset, first);
+    std::memcpy(dst + first, inbound -> data, count - first);
+    inbound -> tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  shm_transport(size_t rank_, size_t world_, const std::string& session, size_t capacity_=(1 << 20)) :
+    transport(rank_, world_), inbound_name{session + "_" + std::to_string(rank_)}, capacity{capacity_}
+  {
+    ::shm_unlink(inbound_name.c_str());
+    const int in_fd = ::shm_open(inbound_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(in_fd < 0){ throw util::system_error("shm_open " + inbound_name); }
+    if(::ftruncate(in_fd, shm_channel::bytes(capacity)) < 0){ throw util::system_error("shm ftruncate"); }
+    inbound = map(in_fd, capacity);
+    ::close(in_fd);
+    inbound -> capacity = capacity;
+    inbound -> head.store(0);
+    inbound -> tail.store(0);
+    inbound -> ready.store(shm_channel::ready_magic, std::memory_order_release);
+
+    const std::string outbound_name = session + "_" + std::to_string(next());
+    for(;;){
+      const int out_fd = ::shm_open(outbound_name.c_str(), O_RDWR, 0600);
+      struct stat info{};
+      if(out_fd >= 0 && ::fstat(out_fd, &info) == 0 && static_cast<size_t>(info.st_size) == shm_channel::bytes(capacity)){
+        outbound = map(out_fd, capacity);
+        ::close(out_fd);
+        break;
+      }
+      if(out_fd >= 0){ ::close(out_fd); }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    while(outbound -> ready.load(std::memory_order_acquire) != shm_channel::ready_magic){
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  ~shm_transport() override {
+    if(outbound != nullptr){ ::munmap(outbound, shm_channel::bytes(capacity)); }
+    if(inbound != nullptr){ ::munmap(inbound, shm_channel::bytes(capacity)); }
+    ::shm_unlink(inbound_name.c_str());
+  }
+};
+
+// in place sum over all ranks: reduce-scatter followed by all-gather, each rank moves
+// 2 * (world - 1) / world of the buffer regardless of the number of ranks.
+template<typename T>
+void ring_allreduce(transport& comm, std::vector<T>& buffer, std::vector<T>& scratch){
+  const size_t world = comm.world;
+  if(world == 1){ return; }
+  const auto bound = [&](const size_t i){ return buffer.size() * i / world; };
+  const auto chunk = [&](const size_t i){ return std::make_pair(bound(i % world), bound(i % world + 1)); };
+  scratch.resize(buffer.size());
+
+  for(size_t s{0}; s + 1 < world; ++s){
+    const auto[send_begin, send_end] = chunk(comm.rank + world - s);
+    const auto[recv_begin, recv_end] = chunk(comm.rank + world - s - 1);
+    comm.exchange(
+      reinterpret_cast<const char*>(buffer.data() + send_begin), (send_end - send_begin) * sizeof(T),
+      reinterpret_cast<char*>(scratch.data() + recv_begin), (recv_end - recv_begin) * sizeof(T)
+    );
+    for(size_t i{recv_begin}; i < recv_end; ++i){ buffer[i] += scratch[i]; }
+  }
+
+  for(size_t s{0}; s + 1 < world; ++s){
+    const auto[send_begin, send_end] = chunk(comm.rank + world + 1 - s);
+    const auto[recv_begin, recv_end] = chunk(comm.rank + world - s);
+    comm.exchange(
+      reinterpret_cast<const char*>(buffer.data() + send_begin), (send_end - send_begin) * sizeof(T),
+      reinterpret_cast<char*>(buffer.data() + recv_begin), (recv_end - recv_begin) * sizeof(T)
+    );
+  }
+}
+
+template<typename W, typename T>
+void flatten(W& w, std::vector<T>& buffer){
+  buffer.clear();
+  w.over([&buffer](const auto& m){ buffer.insert(buffer.end(), m.data(), m.data() + m.size()); });
+}
+
+template<typename W, typename T>
+size_t unflatten(const std::vector<T>& buffer, W& w){
+  size_t offset{0};
+  w.over([&](auto& m){
+    std::copy(buffer.begin() + offset, buffer.begin() + offset + m.size(), m.data());
+    offset += m.size();
+  });
+  return offset;
+}
+
+struct step_stats{
+  double loss{0.0};     // mean over all ranks
+  double compute{0.0};  // seconds spent in forward/backward and data generation
+  double comm{0.0};     // seconds spent in the allreduce
+  double wall{0.0};     // seconds for the whole step
+
+  // fraction of communication hidden behind computation (data generation, see data_parallel).
+  double overlap() const {
+    return comm > 0.0 ? std::clamp((compute + comm - wall) / comm, 0.0, 1.0) : 1.0;
+  }
+
+  // weak scaling efficiency: per rank work is fixed, so ideal scaling keeps a step as fast as
+  // the compute alone.
+  double efficiency() const { return wall > 0.0 ? std::min(compute / wall, 1.0) : 1.0; }
+};
+
+// synchronous data parallel SGD. each rank draws its own trajectories, gradients are averaged
+// with a ring allreduce before step_grad. the allreduce runs on a long lived communication
+// thread while the next trajectory (which does not depend on the weights) is generated; that is
+// the only work it can hide behind, the gradient of a recurrent step is complete only once
+// backward has reached the start of the trajectory.
+template<typename M, typename D>
+struct data_parallel{
+  using info = typename M::info;
+  using real_type = typename info::real_type;
+  using clock = std::chrono::steady_clock;
+
+  train::trainer<M, D> trainer;
+  transport& comm;
+  std::vector<real_type> flat{};
+  std::vector<real_type> scratch{};
+  std::vector<ode::train_pair<typename D::config_type>> upcoming{};
+
+  std::mutex mutex{};
+  std::condition_variable cv{};
+  bool requested{false};
+  bool reduced{false};
+  bool stopping{false};
+  double comm_seconds{0.0};
+  std::thread communicator{};
+
+  void communicate(){
+    std::unique_lock<std::mutex> lock(mutex);
+    for(;;){
+      cv.wait(lock, [this]{ return stopping || requested; });
+      if(stopping){ return; }
+      requested = false;
+      lock.unlock();
+      const auto begin = clock::now();
+      ring_allreduce(comm, flat, scratch);
+      const double seconds = std::chrono::duration<double>(clock::now() - begin).count();
+      lock.lock();
+      comm_seconds = seconds;
+      reduced = true;
+      cv.notify_all();
+    }
+  }
+
+  void prefetch(){
+    if(trainer.update_count % trainer.epoch_size == 0){ trainer.data.grow_domain(); }
+    upcoming = ode::materialize(trainer.data.get_trajectory());
+  }
+
+  // every rank starts from rank 0's weights.
+  void broadcast_weights(){
+    if(comm.world == 1){ return; }
+    flatten(trainer.model.w, flat);
+    const size_t bytes = flat.size() * sizeof(real_type);
+    if(comm.rank != 0){
+      comm.recv(reinterpret_cast<char*>(flat.data()), bytes);
+      unflatten(flat, trainer.model.w);
+    }
+    if(comm.next() != 0){
+      comm.send(reinterpret_cast<const char*>(flat.data()), bytes);
+    }
+  }
+
+  step_stats step(){
+    const auto seconds = [](const auto& begin, const auto& end){ return std::chrono::duration<double>(end - begin).count(); };
+    step_stats stats{};
+    const auto start = clock::now();
+
+    const auto trajectory = std::move(upcoming);
+    ++trainer.update_count;
+    const real_type err = trainer.accumulate_grad(trajectory);
+    // the trajectory came from the last prefetch, which is still the data source's latest draw.
+    trainer.data.report(err);
+    flatten(trainer.model.grad, flat);
+    flat.push_back(err);
+    const auto computed = clock::now();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      requested = true;
+      reduced = false;
+    }
+    cv.notify_all();
+    const auto prefetch_begin = clock::now();
+    prefetch();
+    const auto prefetch_end = clock::now();
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [this]{ return reduced; });
+      stats.comm = comm_seconds;
+    }
+
+    const real_type scale = real_type{1.0} / static_cast<real_type>(comm.world);
+    for(auto& value : flat){ value *= scale; }
+    stats.loss = flat.back();
+    unflatten(flat, trainer.model.grad);
+    trainer.apply_grad();
+
+    stats.compute = seconds(start, computed) + seconds(prefetch_begin, prefetch_end);
+    stats.wall = seconds(start, clock::now());
+    return stats;
+  }
+
+  data_parallel(train::trainer<M, D> trainer_, transport& comm_) : trainer{std::move(trainer_)}, comm{comm_} {
+    broadcast_weights();
+    prefetch();
+    communicator = std::thread([this]{ communicate(); });
+  }
+
+  data_parallel(const data_parallel&) = delete;
+  data_parallel& operator=(const data_parallel&) = delete;
+
+  ~data_parallel(){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+    communicator.join();
+  }
+};
+
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <util.h>
+#include <model.h>
+#include <train.h>
+#include <thread_pool.h>
+#include <ode_data_generator.h>
+
+namespace ensemble{
+
+template<typename Config>
+using batch = std::vector<std::vector<ode::train_pair<Config>>>;
+
+struct hyperparameters{
+  double learning_rate{0.01};
+  double dt{0.0}; // 0.0 keeps the data generator's dt
+  size_t epoch_size{5000};
+};
+
+// the system as a member sees it: a dt override changes the sampling of its training pairs
+// (and with it the gradient scale), not just the model's euler step.
+template<typename Config>
+Config configure(Config c, const hyperparameters& params){
+  if(params.dt > 0.0){ c.dt = params.dt; }
+  return c;
+}
+
+// type erased so members may differ in their compile time latent dimension.
+template<typename Config>
+struct member_base{
+  using real_type = typename Config::real_type;
+  std::string name;
+  hyperparameters params;
+  real_type loss{std::numeric_limits<real_type>::quiet_NaN()};
+  size_t rounds{0};
+  bool pruned{false};
+
+  virtual real_type update(const batch<Config>& b) = 0;
+  // weights only, load them back with dt().
+  virtual void write(std::ostream& os) const = 0;
+  virtual real_type dt() const = 0;
+
+  member_base(std::string name_, hyperparameters params_) : name{std::move(name_)}, params{params_} {}
+  virtual ~member_base() = default;
+};
+
+template<typename M, typename Config>
+struct member : member_base<Config>{
+  using real_type = typename Config::real_type;
+  train::trainer<M, ode::data_generator<Config>> trainer;
+
+  real_type update(const batch<Config>& b) override {
+    real_type err{0.0};
+    for(const auto& trajectory : b){ err += trainer.update_model(trajectory); }
+    return err / static_cast<real_type>(std::max<size_t>(b.size(), 1));
+  }
+
+  void write(std::ostream& os) const override { os << trainer.model; }
+  real_type dt() const override { return trainer.model.dt; }
+
+  member(const Config& c, std::string name_, const hyperparameters& params_) :
+    member_base<Config>(std::move(name_), params_),
+    trainer(M::random(configure(c, params_).dt), ode::data_generator<Config>(configure(c, params_)), params_.epoch_size)
+  {
+    trainer.set_lr(params_.learning_rate);
+  }
+};
+
+template<int Latent, typename Config>
+std::unique_ptr<member_base<Config>> make_member(const Config& c, const hyperparameters& params){
+  using M = dyn::model<util::info<typename Config::real_type, Config::dim, Config::dim, Latent>>;
+  const std::string name =
+    "latent=" + std::to_string(Latent) +
+    " lr=" + std::to_string(params.learning_rate) +
+    " dt=" + std::to_string(configure(c, params).dt) +
+    " epoch=" + std::to_string(params.epoch_size);
+  return std::make_unique<member<M, Config>>(c, name, params);
+}
+
+// trains every member on the same trajectories. data is generated once per round for each
+// distinct (epoch_size, dt) (the domain schedule and the sampling are part of the data, not of
+// the model) and shared.
+template<typename Config>
+struct runner{
+  using real_type = typename Config::real_type;
+
+  struct stream{
+    ode::data_generator<Config> data;
+    size_t epoch_size;
+    size_t update_count{0};
+    batch<Config> current{};
+  };
+
+  Config config;
+  size_t batch_size;
+  util::work_stealing_pool pool;
+  std::vector<std::unique_ptr<member_base<Config>>> members{};
+  std::map<std::pair<size_t, real_type>, stream> streams{};
+  size_t round{0};
+
+  real_type smoothing{0.95};
+  real_type prune_ratio{10.0};
+  size_t prune_warmup{200};
+  size_t prune_rate{100};
+
+  std::pair<size_t, real_type> key_of(const hyperparameters& params) const {
+    return std::make_pair(params.epoch_size, configure(config, params).dt);
+  }
+
+  void add(std::unique_ptr<member_base<Config>> m){
+    const auto key = key_of(m -> params);
+    if(streams.find(key) == streams.end()){
+      streams.emplace(key, stream{ode::data_generator<Config>(configure(config, m -> params)), key.first});
+    }
+    members.push_back(std::move(m));
+  }
+
+  size_t live() const {
+    return std::count_if(members.begin(), members.end(), [](const auto& m){ return !m -> pruned; });
+  }
+
+  void generate(stream& s){
+    s.current.clear();
+    for(size_t i{0}; i < batch_size; ++i){
+      if(s.update_count % s.epoch_size == 0){ s.data.grow_domain(); }
+      ++s.update_count;
+      s.current.push_back(ode::materialize(s.data.get_trajectory()));
+    }
+  }
+
+  // diverged members are dropped as soon as they are seen, they can only waste pool time.
+  void prune_diverged(){
+    for(auto& m : members){
+      if(!m -> pruned && m -> rounds > 0 && !std::isfinite(m -> loss)){ m -> pruned = true; }
+    }
+  }
+
+  void prune(){
+    real_type best = std::numeric_limits<real_type>::infinity();
+    for(const auto& m : members){
+      if(!m -> pruned && std::isfinite(m -> loss)){ best = std::min(best, m -> loss); }
+    }
+    for(auto& m : members){
+      if(m -> pruned){ continue; }
+      if(std::isfinite(best) && m -> loss > prune_ratio * best){ m -> pruned = true; }
+    }
+  }
+
+  void step(){
+    for(auto&[key, s] : streams){
+      const bool used = std::any_of(members.begin(), members.end(), [this, &key](const auto& m){
+        return !m -> pruned && key_of(m -> params) == key;
+      });
+      if(used){ generate(s); }
+    }
+
+    for(auto& m : members){
+      if(m -> pruned){ continue; }
+      member_base<Config>* target = m.get();
+      const batch<Config>* shared = &streams.at(key_of(target -> params)).current;
+      pool.submit([this, target, shared]{
+        const real_type err = target -> update(*shared);
+        target -> loss = (target -> rounds == 0) ? err : smoothing * target -> loss + (real_type{1.0} - smoothing) * err;
+        ++target -> rounds;
+      });
+    }
+    pool.wait();
+
+    ++round;
+    prune_diverged();
+    if(round >= prune_warmup && round % prune_rate == 0){ prune(); }
+  }
+
+  const member_base<Config>& best() const {
+    const auto iter = std::min_element(members.begin(), members.end(), [](const auto& a, const auto& b){
+      const auto key = [](const auto& m){
+        return (m -> pruned || !std::isfinite(m -> loss)) ? std::numeric_limits<real_type>::infinity() : m -> loss;
+      };
+      return key(a) < key(b);
+    });
+    return **iter;
+  }
+
+  void report(std::ostream& os) const {
+    os << "round " << round << ", live " << live() << "/" << members.size() << '\n';
+    for(const auto& m : members){
+      os << std::setw(12) << m -> loss << (m -> pruned ? "  pruned  " : "          ") << m -> name << '\n';
+    }
+  }
+
+  runner(const Config& c, size_t batch_size_=1, size_t threads=std::thread::hardware_concurrency()) :
+    config{c}, batch_size{batch_size_}, pool(threads) {}
+};
+
+}
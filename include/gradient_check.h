@@ -0,0 +1,176 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Dense>
+
+#include <util.h>
+#include <model.h>
+#include <thread_pool.h>
+
+namespace check{
+
+using vec_t = Eigen::VectorXd;
+using mat_t = Eigen::MatrixXd;
+
+// backward computes the vector jacobian product of the scalar
+//   L = out_grad . out + latent_grad . latent_next
+// for one step. gradients of the output side weights (m_out, b_out, m_through) are scaled by dt,
+// the latent side ones carry their dt from the euler step already.
+constexpr bool dt_scaled[] = {true, true, true, false, false, false, false, false};
+constexpr const char* weight_name[] = {"m_out", "b_out", "m_through", "m_in", "b_in", "m_latent", "m_latent_1", "m_latent_2"};
+
+struct result{
+  std::string name;
+  double error;
+  bool passed;
+};
+
+struct report{
+  std::vector<result> results{};
+
+  void add(const std::string& name, const double error, const double tolerance){
+    const bool passed = std::isfinite(error) && error <= tolerance;
+    results.push_back(result{name, error, passed});
+    std::cout << (passed ? "[ ok ] " : "[fail] ") << name << ": relative error " << error << std::endl;
+  }
+
+  bool passed() const {
+    return std::all_of(results.begin(), results.end(), [](const result& r){ return r.passed; });
+  }
+};
+
+inline double relative_error(const double a, const double b){
+  return std::abs(a - b) / std::max({std::abs(a), std::abs(b), 1e-12});
+}
+
+inline double relative_error(const mat_t& a, const mat_t& b){
+  return (a - b).norm() / std::max({a.norm(), b.norm(), 1e-12});
+}
+
+template<typename M>
+struct problem{
+  using info = typename M::info;
+  using real_type = typename info::real_type;
+
+  M model;
+  typename info::in_vec_t input;
+  typename info::latent_vec_t latent;
+  typename info::out_vec_t out_grad;
+  typename info::latent_vec_t latent_grad;
+
+  real_type loss(const M& m, const typename info::in_vec_t& in, const typename info::latent_vec_t& x) const {
+    const auto[out, x_next] = m.forward(typename M::backward_t(in, x));
+    return out_grad.dot(out) + latent_grad.dot(x_next);
+  }
+
+  // joint jacobian of [out; latent_next] w.r.t. the input or the latent, one column per coordinate.
+  vec_t outputs(const typename info::in_vec_t& in, const typename info::latent_vec_t& x) const {
+    const auto[out, x_next] = model.forward(typename M::backward_t(in, x));
+    vec_t result(out.size() + x_next.size());
+    result << out, x_next;
+    return result;
+  }
+
+  problem(const M& m, std::mt19937& generator) : model{m} {
+    const util::dims d = model.dims();
+    std::normal_distribution<real_type> normal{};
+    const auto fill = [&](auto& v, const Eigen::Index n){
+      v.resize(n);
+      v = v.unaryExpr([&](auto){ return normal(generator); });
+    };
+    fill(input, d.input);
+    fill(latent, d.latent);
+    fill(out_grad, d.output);
+    fill(latent_grad, d.latent);
+  }
+};
+
+// every weight block, the input and the latent are each checked along one random direction:
+// two forward calls per check whatever the size. central differences are exact for the
+// (at most quadratic) step, so only rounding remains.
+template<typename M>
+void check_directional(report& r, const std::string& label, problem<M>& p, std::mt19937& generator, const double h, const double tolerance){
+  using info = typename M::info;
+  std::normal_distribution<typename info::real_type> normal{};
+  const auto random_like = [&](const auto& like){
+    std::decay_t<decltype(like)> result = like;
+    result = result.unaryExpr([&](auto){ return normal(generator); });
+    return result;
+  };
+
+  M m = p.model;
+  m.clear_grad();
+  const auto[in_grad, x_grad] = m.backward(typename M::backward_t(p.input, p.latent), typename M::forward_t(p.out_grad, p.latent_grad));
+
+  for(size_t block{0}; block < 8; ++block){
+    M plus = p.model;
+    M minus = p.model;
+    double analytic{0.0};
+    size_t index{0};
+    over_weights([&](auto& w_plus, auto& w_minus, const auto& g){
+      if(index++ != block){ return; }
+      const auto direction = random_like(g);
+      w_plus += h * direction;
+      w_minus -= h * direction;
+      analytic = g.cwiseProduct(direction).sum() / (dt_scaled[block] ? m.dt : 1.0);
+    }, plus.w, minus.w, m.grad);
+    const double numeric = (p.loss(plus, p.input, p.latent) - p.loss(minus, p.input, p.latent)) / (2.0 * h);
+    r.add(label + " d/d" + weight_name[block], relative_error(analytic, numeric), tolerance);
+  }
+
+  const auto direction_in = random_like(p.input);
+  const double numeric_in = (p.loss(p.model, p.input + h * direction_in, p.latent) - p.loss(p.model, p.input - h * direction_in, p.latent)) / (2.0 * h);
+  r.add(label + " d/dinput", relative_error(in_grad.dot(direction_in), numeric_in), tolerance);
+
+  const auto direction_x = random_like(p.latent);
+  const double numeric_x = (p.loss(p.model, p.input, p.latent + h * direction_x) - p.loss(p.model, p.input, p.latent - h * direction_x)) / (2.0 * h);
+  r.add(label + " d/dlatent", relative_error(x_grad.dot(direction_x), numeric_x), tolerance);
+}
+
+// full jacobians of [out; latent_next] w.r.t. input and latent: central difference columns on
+// one side, backward with every unit cotangent (rows) on the other, both spread over the pool.
+template<typename M>
+void check_jacobians(report& r, const std::string& label, const problem<M>& p, util::work_stealing_pool& pool, const double h, const double tolerance){
+  using info = typename M::info;
+  const util::dims d = p.model.dims();
+  const Eigen::Index rows = d.output + d.latent;
+
+  mat_t numeric_in(rows, d.input);
+  mat_t numeric_x(rows, d.latent);
+  pool.parallel_for(static_cast<size_t>(d.input + d.latent), [&](const size_t k){
+    const auto j = static_cast<Eigen::Index>(k);
+    if(j < d.input){
+      typename info::in_vec_t plus = p.input, minus = p.input;
+      plus(j) += h; minus(j) -= h;
+      numeric_in.col(j) = (p.outputs(plus, p.latent) - p.outputs(minus, p.latent)) / (2.0 * h);
+    }else{
+      typename info::latent_vec_t plus = p.latent, minus = p.latent;
+      plus(j - d.input) += h; minus(j - d.input) -= h;
+      numeric_x.col(j - d.input) = (p.outputs(p.input, plus) - p.outputs(p.input, minus)) / (2.0 * h);
+    }
+  });
+
+  mat_t analytic_in(rows, d.input);
+  mat_t analytic_x(rows, d.latent);
+  pool.parallel_for(static_cast<size_t>(rows), [&](const size_t k){
+    const auto i = static_cast<Eigen::Index>(k);
+    M m = p.model;
+    typename info::out_vec_t out_unit = info::out_vec_t::Zero(d.output);
+    typename info::latent_vec_t x_unit = info::latent_vec_t::Zero(d.latent);
+    if(i < d.output){ out_unit(i) = 1.0; }
+    else{ x_unit(i - d.output) = 1.0; }
+    const auto[in_grad, x_grad] = m.backward(typename M::backward_t(p.input, p.latent), typename M::forward_t(out_unit, x_unit));
+    analytic_in.row(i) = in_grad.transpose();
+    analytic_x.row(i) = x_grad.transpose();
+  });
+
+  r.add(label + " jacobian input", relative_error(analytic_in, numeric_in), tolerance);
+  r.add(label + " jacobian latent", relative_error(analytic_x, numeric_x), tolerance);
+}
+
+}
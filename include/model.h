@@ -44,13 +44,35 @@ struct weights{
     return over_weights(std::forward<F>(f), *this);
   }
 
+  void resize(const util::dims& d){
+    m_out.resize(d.output, d.latent);
+    b_out.resize(d.output);
+    m_through.resize(d.output, d.input);
+    m_in.resize(d.latent, d.input);
+    b_in.resize(d.latent);
+    m_latent.resize(d.latent, d.latent);
+    m_latent_1.resize(d.latent, d.latent);
+    m_latent_2.resize(d.latent, d.latent);
+  }
+
+  util::dims dims() const { return util::dims{m_in.cols(), m_out.rows(), m_latent.rows()}; }
+
   weights(){
     over([](auto& in){ in.setZero(); });
   }
 
+  explicit weights(const util::dims& d){
+    resize(d);
+    over([](auto& in){ in.setZero(); });
+  }
+
   static weights<I> random(){
+    return random(util::dims_of<I>());
+  }
+
+  static weights<I> random(const util::dims& d){
     const typename info::real_type init_factor = 0.02;
-    weights<I> result{};
+    weights<I> result(d);
     result.over([init_factor](auto& w){
       w.setRandom();
       w *= init_factor;
@@ -78,6 +100,7 @@ struct model{
   using info = I;
   using forward_t = std::tuple<typename info::out_vec_t, typename info::latent_vec_t>;
   using backward_t = std::tuple<typename info::in_vec_t, typename info::latent_vec_t>;  
+  using forward_batch_t = std::tuple<typename info::out_batch_t, typename info::latent_batch_t>;
 
 
   weights<info> w{};
@@ -101,6 +124,16 @@ struct model{
     return forward_t(out, x + _dx_dt(state) * dt);
   }
 
+  // one column per independent state, equivalent to calling forward on every column.
+  forward_batch_t forward_batch(const typename info::in_batch_t& env, const typename info::latent_batch_t& x) const {
+    typename info::out_batch_t out = w.m_through * env + w.m_out * x;
+    out.colwise() += w.b_out;
+    typename info::latent_batch_t dx_dt = w.m_in * env + w.m_latent * x;
+    dx_dt.colwise() += w.b_in;
+    dx_dt += (w.m_latent_1 * x).cwiseProduct(w.m_latent_2 * x);
+    return forward_batch_t(out, x + dx_dt * dt);
+  }
+
   forward_t time_reverse(const backward_t& state) const {
     const auto&[env, x] = state;
     const typename info::out_vec_t out = w.m_through * env+  w.m_out * x + w.b_out;
@@ -125,8 +158,8 @@ struct model{
     grad.m_latent_2 +=  left.cwiseProduct(x_grad) * x.transpose() * dt;
 
     const typename info::latent_mat_t hadamard_jacobian =
-      (left.template replicate<1, info::latent_dim>()).cwiseProduct(w.m_latent_2) + 
-      (right.template replicate<1, info::latent_dim>()).cwiseProduct(w.m_latent_1);
+      left.asDiagonal() * w.m_latent_2 +
+      right.asDiagonal() * w.m_latent_1;
 
     const typename info::latent_vec_t x_grad_next =
       x_grad + 
@@ -135,6 +168,7 @@ struct model{
       (x_grad.transpose() * hadamard_jacobian).transpose() * dt;
 
     const typename info::in_vec_t in_grad_next =
+      (env_grad.transpose() * w.m_through).transpose() +
       (x_grad.transpose() * w.m_in).transpose() * dt;
 
     return backward_t(in_grad_next, x_grad_next);
@@ -151,12 +185,16 @@ struct model{
     over_weights(update_rule, w, grad);
   }
 
+  util::dims dims() const { return w.dims(); }
+
   model(const typename info::real_type& dt_) : dt{dt_} {}
 
+  model(const util::dims& d, const typename info::real_type& dt_) : w{d}, grad{d}, dt{dt_} {}
+
   template<typename ... Args>
   static model<I> random(Args&& ... args){
     model<I> result(std::forward<Args>(args)...);
-    result.w = weights<I>::random();
+    result.w = weights<I>::random(result.dims());
     return result;
   }
 };
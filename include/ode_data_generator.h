@@ -1,5 +1,9 @@
+#pragma once
 #include <iostream>
 #include <random>
+#include <string>
+#include <vector>
+#include <cassert>
 
 #include <Eigen/Dense>
 
@@ -53,8 +57,18 @@ struct trajectory{
   trajectory(const Config& c_, const Matrix<typename Config::real_type, Config::dim, 1>& X_) : c{c_}, X{X_} {}
 };
 
+// evaluates a trajectory once so several consumers can iterate it without re-integrating.
+template<typename Config>
+std::vector<train_pair<Config>> materialize(const trajectory<Config>& t){
+  std::vector<train_pair<Config>> result{};
+  result.reserve(t.c.steps);
+  for(auto&& pair : t){ result.push_back(pair); }
+  return result;
+}
+
 template<typename Config>
 struct data_generator{
+  using config_type = Config;
   static constexpr int dim = Config::dim;
   static constexpr int input_dim = dim;
   static constexpr int output_dim = dim;
@@ -90,7 +104,27 @@ struct data_generator{
     return trajectory<Config>(c, X);
   }
 
+  // feedback on the last trajectory, unused by the uniform sampler.
+  void report(const typename Config::real_type&){}
+
   data_generator(Config c_) : c{c_} {}
 };
 
+template<typename Config>
+std::ostream& operator<<(std::ostream& os, const data_generator<Config>& d){
+  os << "domain " << d.distribution.min() << ' ' << d.distribution.max() << '\n';
+  os << "generator " << d.generator << '\n';
+  return os;
+}
+
+template<typename Config>
+std::istream& operator>>(std::istream& is, data_generator<Config>& d){
+  std::string key{};
+  typename Config::real_type min{}, max{};
+  is >> key >> min >> max; assert((key == "domain"));
+  d.distribution = decltype(d.distribution)(min, max);
+  is >> key >> d.generator; assert((key == "generator"));
+  return is;
+}
+
 }
\ No newline at end of file
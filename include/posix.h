@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+namespace util{
+
+// wraps the errno of a failed system call, e.g. throw system_error("bind " + path).
+inline std::runtime_error system_error(const std::string& what){
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+}
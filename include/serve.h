@@ -0,0 +1,347 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <posix.h>
+#include <model.h>
+
+namespace serve{
+
+// wire format, all little endian host order (the server is local):
+//   on connect the server sends a handshake with the model's dimensions.
+//   request:  uint32 op, uint32 reserved, input_dim doubles (ignored for reset).
+//   response: output_dim doubles, sent for step requests only.
+enum class op : uint32_t { step = 1, reset = 2 };
+
+struct handshake{
+  uint32_t input_dim;
+  uint32_t output_dim;
+  uint32_t latent_dim;
+  uint32_t reserved;
+};
+
+struct request_header{
+  uint32_t code;
+  uint32_t reserved;
+};
+
+inline bool write_all(const int fd, const void* data, size_t n){
+  const char* bytes = static_cast<const char*>(data);
+  while(n > 0){
+    const ssize_t result = ::send(fd, bytes, n, MSG_NOSIGNAL);
+    if(result < 0){
+      if(errno == EINTR){ continue; }
+      return false;
+    }
+    bytes += result; n -= static_cast<size_t>(result);
+  }
+  return true;
+}
+
+inline bool read_all(const int fd, void* data, size_t n){
+  char* bytes = static_cast<char*>(data);
+  while(n > 0){
+    const ssize_t result = ::recv(fd, bytes, n, 0);
+    if(result < 0 && errno == EINTR){ continue; }
+    if(result <= 0){ return false; }
+    bytes += result; n -= static_cast<size_t>(result);
+  }
+  return true;
+}
+
+// per session latent state, slots are recycled through a free list.
+template<typename I>
+struct session_slab{
+  using info = I;
+  std::vector<typename info::latent_vec_t> slots{};
+  std::vector<size_t> free{};
+  Eigen::Index latent_dim;
+
+  size_t acquire(){
+    size_t index{};
+    if(free.empty()){
+      index = slots.size();
+      slots.emplace_back();
+    }else{
+      index = free.back();
+      free.pop_back();
+    }
+    slots[index] = info::latent_vec_t::Zero(latent_dim);
+    return index;
+  }
+
+  void release(const size_t index){ free.push_back(index); }
+
+  typename info::latent_vec_t& operator[](const size_t index){ return slots[index]; }
+
+  explicit session_slab(Eigen::Index latent_dim_) : latent_dim{latent_dim_} {}
+};
+
+// single threaded event loop: requests are read as they arrive and queued; the queue is run as
+// one latent_dim x B forward once it reaches max_batch or its oldest request has waited `window`.
+template<typename M>
+struct server{
+  using info = typename M::info;
+  using clock = std::chrono::steady_clock;
+
+  struct connection{
+    int fd;
+    size_t slot;
+    std::vector<char> buffer{};
+    std::vector<char> outbox{}; // response bytes the peer has not taken yet
+    bool waiting{false};
+  };
+
+  struct pending{
+    size_t connection;
+    typename info::in_vec_t input;
+    clock::time_point arrival;
+  };
+
+  M model;
+  std::string path;
+  std::chrono::microseconds window;
+  size_t max_batch;
+  int listener{-1};
+  session_slab<info> slab;
+  std::vector<connection> connections{};
+  std::vector<pending> queue{};
+  std::atomic<bool> stopping{false};
+
+  size_t batches{0};
+  size_t steps{0};
+
+  Eigen::Index input_dim() const { return model.w.m_in.cols(); }
+  Eigen::Index output_dim() const { return model.w.m_out.rows(); }
+  Eigen::Index latent_dim() const { return model.w.m_latent.rows(); }
+  size_t request_size() const { return sizeof(request_header) + sizeof(double) * input_dim(); }
+
+  void close_connection(const size_t index){
+    ::close(connections[index].fd);
+    slab.release(connections[index].slot);
+    queue.erase(std::remove_if(queue.begin(), queue.end(), [index](const pending& p){ return p.connection == index; }), queue.end());
+    for(auto& p : queue){ if(p.connection > index){ --p.connection; } }
+    connections.erase(connections.begin() + index);
+  }
+
+  void accept_connections(){
+    for(;;){
+      const int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK);
+      if(fd < 0){ return; }
+      const handshake hs{
+        static_cast<uint32_t>(input_dim()),
+        static_cast<uint32_t>(output_dim()),
+        static_cast<uint32_t>(latent_dim()),
+        0
+      };
+      connections.push_back(connection{fd, slab.acquire()});
+      const char* bytes = reinterpret_cast<const char*>(&hs);
+      connections.back().outbox.assign(bytes, bytes + sizeof(hs));
+      if(!flush(connections.size() - 1)){ close_connection(connections.size() - 1); }
+    }
+  }
+
+  // sends as much of the outbox as the socket takes without blocking, the rest goes out on
+  // POLLOUT. returns false once the peer is gone.
+  bool flush(const size_t index){
+    connection& c = connections[index];
+    size_t sent{0};
+    while(sent < c.outbox.size()){
+      const ssize_t result = ::send(c.fd, c.outbox.data() + sent, c.outbox.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+      if(result > 0){ sent += static_cast<size_t>(result); continue; }
+      if(result < 0 && errno == EINTR){ continue; }
+      if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){ break; }
+      return false;
+    }
+    c.outbox.erase(c.outbox.begin(), c.outbox.begin() + sent);
+    return true;
+  }
+
+  // consumes complete requests from the connection buffer, at most one step per session in flight.
+  // a session whose responses are still queued is not read from, which throttles slow readers.
+  void parse(const size_t index){
+    connection& c = connections[index];
+    size_t offset{0};
+    while(!c.waiting && c.outbox.empty() && c.buffer.size() - offset >= request_size()){
+      request_header header{};
+      std::memcpy(&header, c.buffer.data() + offset, sizeof(header));
+      if(header.code == static_cast<uint32_t>(op::reset)){
+        slab[c.slot].setZero();
+      }else{
+        typename info::in_vec_t input = info::in_vec_t::Zero(input_dim());
+        const char* values = c.buffer.data() + offset + sizeof(header);
+        for(Eigen::Index i{0}; i < input_dim(); ++i){
+          double value{};
+          std::memcpy(&value, values + sizeof(double) * i, sizeof(double));
+          input(i) = static_cast<typename info::real_type>(value);
+        }
+        queue.push_back(pending{index, input, clock::now()});
+        c.waiting = true;
+      }
+      offset += request_size();
+    }
+    c.buffer.erase(c.buffer.begin(), c.buffer.begin() + offset);
+  }
+
+  // returns false once the peer is gone.
+  bool receive(const size_t index){
+    char chunk[4096];
+    for(;;){
+      const ssize_t result = ::recv(connections[index].fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+      if(result > 0){
+        connections[index].buffer.insert(connections[index].buffer.end(), chunk, chunk + result);
+        continue;
+      }
+      if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){ break; }
+      if(result < 0 && errno == EINTR){ continue; }
+      return false;
+    }
+    parse(index);
+    return true;
+  }
+
+  void run_batch(){
+    const size_t count = std::min(queue.size(), max_batch);
+    const auto b = static_cast<Eigen::Index>(count);
+    typename info::in_batch_t env(input_dim(), b);
+    typename info::latent_batch_t x(latent_dim(), b);
+    for(size_t k{0}; k < count; ++k){
+      env.col(k) = queue[k].input;
+      x.col(k) = slab[connections[queue[k].connection].slot];
+    }
+
+    const auto[out, x_next] = model.forward_batch(env, x);
+
+    std::vector<double> response(output_dim());
+    std::vector<size_t> broken{};
+    for(size_t k{0}; k < count; ++k){
+      connection& c = connections[queue[k].connection];
+      slab[c.slot] = x_next.col(k);
+      for(Eigen::Index i{0}; i < output_dim(); ++i){ response[i] = static_cast<double>(out(i, k)); }
+      c.waiting = false;
+      const char* bytes = reinterpret_cast<const char*>(response.data());
+      c.outbox.insert(c.outbox.end(), bytes, bytes + sizeof(double) * response.size());
+      if(!flush(queue[k].connection)){ broken.push_back(queue[k].connection); }
+    }
+    queue.erase(queue.begin(), queue.begin() + count);
+    ++batches; steps += count;
+
+    std::sort(broken.begin(), broken.end());
+    for(auto iter = broken.rbegin(); iter != broken.rend(); ++iter){ close_connection(*iter); }
+    // sessions which pipelined requests may already have their next one buffered.
+    for(size_t index{0}; index < connections.size(); ++index){
+      if(!connections[index].buffer.empty()){ parse(index); }
+    }
+  }
+
+  void run(){
+    std::vector<pollfd> fds{};
+    while(!stopping.load()){
+      fds.clear();
+      fds.push_back(pollfd{listener, POLLIN, 0});
+      for(const auto& c : connections){
+        // a session is only read from once its last response is fully out, so a slow or
+        // pipelining peer is held back by its own socket buffers rather than by our memory.
+        const short events = !c.outbox.empty() ? POLLOUT : (c.waiting ? 0 : POLLIN);
+        fds.push_back(pollfd{c.fd, events, 0});
+      }
+
+      timespec timeout{0, 100'000'000};
+      if(!queue.empty()){
+        const auto remaining = std::max(clock::duration::zero(), queue.front().arrival + window - clock::now());
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+        timeout = timespec{static_cast<time_t>(ns / 1'000'000'000), static_cast<long>(ns % 1'000'000'000)};
+      }
+      if(::ppoll(fds.data(), fds.size(), &timeout, nullptr) < 0 && errno != EINTR){ throw util::system_error("ppoll"); }
+
+      for(size_t i{fds.size() - 1}; i > 0; --i){
+        if(fds[i].revents == 0){ continue; }
+        bool alive = (fds[i].revents & POLLOUT) ? flush(i - 1) : true;
+        if(alive && (fds[i].revents & ~POLLOUT)){ alive = receive(i - 1); }
+        else if(alive){ parse(i - 1); }
+        if(!alive){ close_connection(i - 1); }
+      }
+      if(fds[0].revents & POLLIN){ accept_connections(); }
+
+      while(queue.size() >= max_batch){ run_batch(); }
+      if(!queue.empty() && clock::now() >= queue.front().arrival + window){ run_batch(); }
+    }
+  }
+
+  server(const M& m, const std::string& path_, std::chrono::microseconds window_, size_t max_batch_) :
+    model{m}, path{path_}, window{window_}, max_batch{std::max<size_t>(max_batch_, 1)}, slab(m.w.m_latent.rows())
+  {
+    listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if(listener < 0){ throw util::system_error("socket"); }
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path)){ throw std::runtime_error("socket path too long: " + path); }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    ::unlink(path.c_str());
+    if(::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0){ throw util::system_error("bind " + path); }
+    if(::listen(listener, 128) < 0){ throw util::system_error("listen"); }
+  }
+
+  server(const server&) = delete;
+  server& operator=(const server&) = delete;
+
+  ~server(){
+    for(const auto& c : connections){ ::close(c.fd); }
+    ::close(listener);
+    ::unlink(path.c_str());
+  }
+};
+
+// blocking client, one session per connection.
+struct client{
+  int fd{-1};
+  handshake dims{};
+
+  std::vector<double> step(const std::vector<double>& input){
+    std::vector<char> message(sizeof(request_header) + sizeof(double) * dims.input_dim);
+    const request_header header{static_cast<uint32_t>(op::step), 0};
+    std::memcpy(message.data(), &header, sizeof(header));
+    std::memcpy(message.data() + sizeof(header), input.data(), sizeof(double) * std::min<size_t>(input.size(), dims.input_dim));
+    if(!write_all(fd, message.data(), message.size())){ throw util::system_error("client send"); }
+    std::vector<double> output(dims.output_dim);
+    if(!read_all(fd, output.data(), sizeof(double) * output.size())){ throw util::system_error("client recv"); }
+    return output;
+  }
+
+  void reset(){
+    std::vector<char> message(sizeof(request_header) + sizeof(double) * dims.input_dim, 0);
+    const request_header header{static_cast<uint32_t>(op::reset), 0};
+    std::memcpy(message.data(), &header, sizeof(header));
+    if(!write_all(fd, message.data(), message.size())){ throw util::system_error("client send"); }
+  }
+
+  explicit client(const std::string& path){
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0){ throw util::system_error("socket"); }
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0){ throw util::system_error("connect " + path); }
+    if(!read_all(fd, &dims, sizeof(dims))){ throw util::system_error("handshake"); }
+  }
+
+  client(const client&) = delete;
+  client& operator=(const client&) = delete;
+  ~client(){ if(fd >= 0){ ::close(fd); } }
+};
+
+}
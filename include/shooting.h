@@ -0,0 +1,123 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <model.h>
+#include <train.h>
+#include <thread_pool.h>
+#include <ode_data_generator.h>
+
+namespace train{
+
+// multiple shooting: each trajectory is cut into `segments` pieces, every piece after the first
+// starts from its own latent (a free variable for the duration of the trajectory) and a penalty
+// continuity * |end of piece s-1 - start of piece s|^2 ties the pieces together. forward and
+// backward then run over all pieces at once on the pool instead of one long sequential chain.
+// the starts begin at zero (no serial rollout) and every one of the `inner_steps` passes over
+// the trajectory moves both the weights and the starts.
+template<typename M, typename D>
+struct multiple_shooting{
+  using info = typename M::info;
+  using real_type = typename info::real_type;
+  using latent_vec_t = typename info::latent_vec_t;
+
+  struct segment{
+    size_t begin;
+    size_t end;
+    M local;
+    std::vector<sample<info>> history{};
+    latent_vec_t start;
+    latent_vec_t last;
+    latent_vec_t end_grad;
+    latent_vec_t start_grad;
+    real_type err{0.0};
+  };
+
+  trainer<M, D> base;
+  size_t segments;
+  real_type continuity;
+  real_type latent_lr;
+  size_t inner_steps;
+  util::work_stealing_pool pool;
+
+  template<typename T>
+  void forward(segment& s, const T& trajectory){
+    s.local.w = base.model.w;
+    s.local.clear_grad();
+    s.history.clear();
+    s.err = real_type{0.0};
+    latent_vec_t latent = s.start;
+    real_type t = base.data.dt() * static_cast<real_type>(s.begin);
+    for(size_t i{s.begin}; i < s.end; ++i){
+      const auto&[input, target] = trajectory[i];
+      const typename info::out_vec_t exp_out = target;
+      const auto[out, next_latent] = s.local.forward(typename M::backward_t(input, latent));
+      s.history.push_back(sample<info>{t, input, base.data.gradient(exp_out, out), latent});
+      s.err += base.data.error(exp_out, out);
+      latent = next_latent;
+      t += base.data.dt();
+    }
+    s.last = latent;
+  }
+
+  void backward(segment& s){
+    latent_vec_t latent_grad = s.end_grad;
+    for(auto iter = s.history.rbegin(); iter != s.history.rend(); ++iter){
+      const auto grad_info = typename M::forward_t(iter -> gradient, latent_grad);
+      const auto state_info = typename M::backward_t(iter -> input, iter -> latent);
+      const auto[_, latent_grad_next] = s.local.backward(state_info, grad_info);
+      (void)_;
+      latent_grad = latent_grad_next;
+    }
+    s.start_grad = latent_grad;
+  }
+
+  real_type update_model(){
+    base.prepare_domain();
+    ++base.update_count;
+    const auto trajectory = ode::materialize(base.data.get_trajectory());
+    const latent_vec_t zero = latent_vec_t::Zero(base.model.dims().latent);
+
+    const size_t count = std::max<size_t>(1, std::min(segments, trajectory.size()));
+    std::vector<segment> pieces{};
+    for(size_t s{0}; s < count; ++s){
+      pieces.push_back(segment{trajectory.size() * s / count, trajectory.size() * (s + 1) / count, base.model, {}, zero, zero, zero, zero});
+    }
+
+    real_type err{0.0};
+    const size_t steps = std::max<size_t>(inner_steps, 1);
+    for(size_t step{0}; step < steps; ++step){
+      pool.parallel_for(count, [&](const size_t s){ forward(pieces[s], trajectory); });
+
+      for(size_t s{0}; s < count; ++s){
+        pieces[s].end_grad = (s + 1 < count) ?
+          latent_vec_t(real_type{2.0} * continuity * (pieces[s].last - pieces[s + 1].start)) :
+          zero;
+      }
+
+      pool.parallel_for(count, [&](const size_t s){ backward(pieces[s]); });
+
+      // the first piece always starts from the zero latent, as it does at inference. the starts
+      // move before the next pass uses them, after the last pass they would not be used again.
+      for(size_t s{1}; step + 1 < steps && s < count; ++s){
+        const latent_vec_t penalty_grad = pieces[s - 1].end_grad * real_type{-1.0};
+        pieces[s].start -= latent_lr * (pieces[s].start_grad + penalty_grad);
+      }
+
+      err = real_type{0.0};
+      for(auto& s : pieces){
+        over_weights([](auto& total, const auto& part){ total += part; }, base.model.grad, s.local.grad);
+        err += s.err;
+      }
+      base.apply_grad();
+    }
+    base.data.report(err);
+    return err;
+  }
+
+  multiple_shooting(trainer<M, D> base_, size_t segments_, real_type continuity_=1.0, real_type latent_lr_=0.25, size_t inner_steps_=4, size_t threads=std::thread::hardware_concurrency()) :
+    base{std::move(base_)}, segments{segments_}, continuity{continuity_}, latent_lr{latent_lr_}, inner_steps{inner_steps_}, pool(threads) {}
+};
+
+}
@@ -0,0 +1,308 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <exception>
+#include <stdexcept>
+#include <cassert>
+#include <cstdlib>
+#include <algorithm>
+
+#include <Eigen/Dense>
+
+namespace stream{
+
+// csv: one record per line, values separated by commas and/or whitespace. blank lines, lines
+// starting with '#' and lines that do not parse as numbers (headers) are skipped.
+// binary: records of `columns` doubles back to back, host byte order, no header.
+enum class format { csv, binary };
+
+// pairs: every record holds the input followed by the expected output.
+// states: every record is one state, the training pair is (record t, record t + 1).
+enum class layout { pairs, states };
+
+inline format format_of(const std::string& path){
+  const std::string ext = ".csv";
+  const bool csv = path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+  return csv ? format::csv : format::binary;
+}
+
+// sequential record reader over one file, holds a single line / record in memory.
+struct record_reader{
+  std::string path;
+  format fmt;
+  size_t columns;
+  std::ifstream file{};
+  std::string line{};
+
+  void rewind(){
+    file.close();
+    file.clear();
+    file.open(path, fmt == format::binary ? std::ios::in | std::ios::binary : std::ios::in);
+    if(!file){ throw std::runtime_error("stream: cannot open " + path); }
+  }
+
+  bool parse(const std::string& text, double* out) const {
+    const char* begin = text.c_str();
+    size_t count{0};
+    for(;;){
+      while(*begin == ' ' || *begin == '\t' || *begin == ',' || *begin == '\r'){ ++begin; }
+      if(*begin == '\0'){ break; }
+      char* end{nullptr};
+      const double value = std::strtod(begin, &end);
+      if(end == begin || count == columns){ return false; }
+      out[count++] = value;
+      begin = end;
+    }
+    return count == columns;
+  }
+
+  // reads the next record into out, false at end of file.
+  bool next(double* out){
+    if(fmt == format::binary){
+      file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(sizeof(double) * columns));
+      return file.gcount() == static_cast<std::streamsize>(sizeof(double) * columns);
+    }
+    while(std::getline(file, line)){
+      if(line.empty() || line[0] == '#'){ continue; }
+      if(parse(line, out)){ return true; }
+    }
+    return false;
+  }
+
+  // positions the reader at record `row` of the file.
+  void seek(const size_t row){
+    rewind();
+    if(fmt == format::binary){
+      file.seekg(static_cast<std::streamoff>(sizeof(double) * columns * row));
+      return;
+    }
+    std::vector<double> scratch(columns);
+    for(size_t i{0}; i < row && next(scratch.data()); ++i){}
+  }
+
+  record_reader(const std::string& path_, format fmt_, size_t columns_) : path{path_}, fmt{fmt_}, columns{columns_} { rewind(); }
+};
+
+// a block of consecutive records. `restart` marks the first block of a new pass over the file.
+struct chunk{
+  std::vector<double> values{};
+  size_t rows{0};
+  bool restart{false};
+};
+
+// reads the file in chunks of `chunk_rows` records on a background thread, keeping at most
+// `depth` chunks ahead of the consumer. wraps around at end of file, so it never runs dry.
+struct readahead{
+  record_reader reader;
+  size_t chunk_rows;
+  size_t depth;
+
+  std::mutex mutex{};
+  std::condition_variable cv{};
+  std::deque<chunk> ready{};
+  std::exception_ptr failure{};
+  bool stopping{false};
+  std::thread worker{};
+
+  void produce(size_t row){
+    try{
+      reader.seek(row);
+      bool restart{false};
+      size_t rows_in_pass{row};
+      for(;;){
+        chunk c{std::vector<double>(chunk_rows * reader.columns), 0, restart};
+        restart = false;
+        while(c.rows < chunk_rows && reader.next(c.values.data() + c.rows * reader.columns)){ ++c.rows; }
+        rows_in_pass += c.rows;
+        const bool exhausted = c.rows < chunk_rows;
+        if(exhausted && rows_in_pass == 0){ throw std::runtime_error("stream: no records in " + reader.path); }
+        c.values.resize(c.rows * reader.columns);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]{ return stopping || ready.size() < depth; });
+        if(stopping){ return; }
+        if(c.rows > 0 || c.restart){ ready.push_back(std::move(c)); }
+        lock.unlock();
+        cv.notify_all();
+
+        if(exhausted){
+          reader.rewind();
+          restart = true;
+          rows_in_pass = 0;
+        }
+      }
+    }catch(...){
+      std::lock_guard<std::mutex> lock(mutex);
+      failure = std::current_exception();
+      cv.notify_all();
+    }
+  }
+
+  void stop(){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+    if(worker.joinable()){ worker.join(); }
+  }
+
+  // restarts reading at record `row` of the file, dropping anything read ahead.
+  void start(const size_t row){
+    stop();
+    ready.clear();
+    failure = nullptr;
+    stopping = false;
+    worker = std::thread([this, row]{ produce(row); });
+  }
+
+  chunk next(){
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]{ return !ready.empty() || failure; });
+    if(ready.empty()){ std::rethrow_exception(failure); }
+    chunk result = std::move(ready.front());
+    ready.pop_front();
+    lock.unlock();
+    cv.notify_all();
+    return result;
+  }
+
+  readahead(const std::string& path, format fmt, size_t columns, size_t chunk_rows_, size_t depth_) :
+    reader(path, fmt, columns), chunk_rows{std::max<size_t>(chunk_rows_, 1)}, depth{std::max<size_t>(depth_, 1)} {}
+
+  readahead(const readahead&) = delete;
+  readahead& operator=(const readahead&) = delete;
+  ~readahead(){ stop(); }
+};
+
+template<typename T, int Input, int Output>
+struct train_pair{
+  Eigen::Matrix<T, Input, 1> input;
+  Eigen::Matrix<T, Output, 1> output;
+};
+
+// data source for train::trainer over a recorded time series. the file is consumed as a stream
+// of records; every get_trajectory() returns the next `window` consecutive training pairs, and
+// successive windows start `stride` pairs apart. windows never straddle the end of the file.
+// memory use is bounded by the window plus the readahead, independent of the file size.
+// copies share the underlying reader, so give each trainer its own series.
+template<typename T, int Input, int Output>
+struct series{
+  using real_type = T;
+  using pair_t = train_pair<T, Input, Output>;
+  static constexpr int input_dim = Input;
+  static constexpr int output_dim = Output;
+  static_assert(Input != Eigen::Dynamic && Output != Eigen::Dynamic);
+
+  real_type step;
+  size_t window;
+  size_t stride;
+  layout arrangement;
+  std::shared_ptr<readahead> source;
+
+  std::deque<pair_t> pending{};
+  std::vector<pair_t> current{};
+  std::vector<double> previous{};
+  size_t epoch{0};
+  size_t row{0}; // record index (within the pass) of pending.front()
+  bool from_start{true};
+
+  static size_t columns_for(const layout l){ return l == layout::pairs ? Input + Output : Input; }
+
+  void grow_domain(){}
+  void report(const real_type&){}
+
+  real_type dt() const { return step; }
+
+  template<typename V>
+  V gradient(const V& true_, const V& pred_) const {
+    return (2.0 * (pred_ - true_)).eval() * dt();
+  }
+
+  template<typename V>
+  real_type error(const V& true_, const V& pred_) const {
+    return ((pred_ - true_).eval()).squaredNorm();
+  }
+
+  void restart(){
+    if(from_start && row == 0 && pending.size() < window){ throw std::runtime_error("stream: series shorter than one window"); }
+    from_start = true;
+    pending.clear();
+    previous.clear();
+    ++epoch;
+    row = 0;
+  }
+
+  void push(const double* record){
+    pair_t p{};
+    if(arrangement == layout::pairs){
+      for(int i{0}; i < Input; ++i){ p.input(i) = static_cast<real_type>(record[i]); }
+      for(int i{0}; i < Output; ++i){ p.output(i) = static_cast<real_type>(record[Input + i]); }
+      pending.push_back(p);
+      return;
+    }
+    if(!previous.empty()){
+      for(int i{0}; i < Input; ++i){ p.input(i) = static_cast<real_type>(previous[i]); }
+      for(int i{0}; i < Output; ++i){ p.output(i) = static_cast<real_type>(record[i]); }
+      pending.push_back(p);
+    }
+    previous.assign(record, record + Input);
+  }
+
+  const std::vector<pair_t>& get_trajectory(){
+    while(pending.size() < window){
+      const chunk c = source -> next();
+      if(c.restart){ restart(); }
+      const size_t columns = columns_for(arrangement);
+      for(size_t i{0}; i < c.rows; ++i){ push(c.values.data() + i * columns); }
+    }
+    current.assign(pending.begin(), pending.begin() + window);
+    const size_t advance = std::min(stride, pending.size());
+    pending.erase(pending.begin(), pending.begin() + advance);
+    row += advance;
+    return current;
+  }
+
+  // resumes at record `row_` of pass `epoch_`, as written by operator<<.
+  void seek(const size_t epoch_, const size_t row_){
+    pending.clear();
+    previous.clear();
+    epoch = epoch_;
+    row = row_;
+    from_start = row == 0;
+    source -> start(row);
+  }
+
+  series(const std::string& path, real_type dt_, size_t window_, size_t stride_, layout arrangement_=layout::states, size_t chunk_rows=4096, size_t depth=4) :
+    step{dt_}, window{std::max<size_t>(window_, 1)}, stride{std::max<size_t>(stride_, 1)}, arrangement{arrangement_},
+    source{std::make_shared<readahead>(path, format_of(path), columns_for(arrangement_), chunk_rows, depth)}
+  {
+    assert((arrangement == layout::pairs || Input == Output));
+    source -> start(0);
+  }
+};
+
+template<typename T, int Input, int Output>
+std::ostream& operator<<(std::ostream& os, const series<T, Input, Output>& d){
+  os << "stream " << d.epoch << ' ' << d.row << '\n';
+  return os;
+}
+
+template<typename T, int Input, int Output>
+std::istream& operator>>(std::istream& is, series<T, Input, Output>& d){
+  std::string key{};
+  size_t epoch{0}, row{0};
+  is >> key >> epoch >> row; assert((key == "stream"));
+  d.seek(epoch, row);
+  return is;
+}
+
+}
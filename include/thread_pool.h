@@ -0,0 +1,152 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+namespace util{
+
+// every worker owns a deque: it pops its own tasks from the back and steals from the front of
+// the others when it runs dry. tasks submitted from inside a worker land on that worker's deque.
+struct work_stealing_pool{
+  using task_t = std::function<void()>;
+
+  struct queue{
+    std::mutex mutex{};
+    std::deque<task_t> tasks{};
+  };
+
+  std::vector<std::unique_ptr<queue>> queues{};
+  std::vector<std::thread> workers{};
+  std::mutex state_mutex{};
+  std::condition_variable work_available{};
+  std::condition_variable idle{};
+  std::atomic<size_t> queued{0};
+  std::atomic<size_t> unfinished{0};
+  std::atomic<size_t> next_queue{0};
+  bool stopping{false};
+
+  static inline thread_local const work_stealing_pool* current_pool{nullptr};
+  static inline thread_local size_t current_index{0};
+
+  size_t size() const { return workers.size(); }
+
+  bool pop(const size_t index, task_t& task){
+    {
+      queue& own = *queues[index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if(!own.tasks.empty()){
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        --queued;
+        return true;
+      }
+    }
+    for(size_t offset{1}; offset < queues.size(); ++offset){
+      queue& victim = *queues[(index + offset) % queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if(!victim.tasks.empty()){
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        --queued;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void finish(task_t& task){
+    task();
+    if(--unfinished == 0){
+      std::lock_guard<std::mutex> lock(state_mutex);
+      idle.notify_all();
+    }
+  }
+
+  void work(const size_t index){
+    current_pool = this;
+    current_index = index;
+    for(;;){
+      task_t task{};
+      if(pop(index, task)){
+        finish(task);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(state_mutex);
+      work_available.wait(lock, [this]{ return stopping || queued.load() > 0; });
+      if(stopping && queued.load() == 0){ return; }
+    }
+  }
+
+  template<typename F>
+  void submit(F&& f){
+    const size_t index = (current_pool == this) ? current_index : (next_queue++ % queues.size());
+    ++unfinished;
+    {
+      std::lock_guard<std::mutex> lock(state_mutex);
+      ++queued;
+    }
+    {
+      queue& target = *queues[index];
+      std::lock_guard<std::mutex> lock(target.mutex);
+      target.tasks.emplace_back(std::forward<F>(f));
+    }
+    work_available.notify_one();
+  }
+
+  // runs one pending task on the calling thread, used so waiting threads help instead of idling.
+  bool run_one(){
+    task_t task{};
+    const size_t index = (current_pool == this) ? current_index : (next_queue++ % queues.size());
+    if(!pop(index, task)){ return false; }
+    finish(task);
+    return true;
+  }
+
+  // blocks until every submitted task has finished.
+  void wait(){
+    while(run_one()){}
+    std::unique_lock<std::mutex> lock(state_mutex);
+    idle.wait(lock, [this]{ return unfinished.load() == 0; });
+  }
+
+  // calls f(i) for i in [0, n) and returns once all of them are done. safe to call from a task.
+  template<typename F>
+  void parallel_for(const size_t n, F&& f){
+    std::atomic<size_t> remaining{n};
+    for(size_t i{0}; i < n; ++i){
+      submit([&f, &remaining, i]{
+        f(i);
+        --remaining;
+      });
+    }
+    while(remaining.load() > 0){
+      if(!run_one()){ std::this_thread::yield(); }
+    }
+  }
+
+  explicit work_stealing_pool(size_t threads=std::thread::hardware_concurrency()){
+    threads = std::max<size_t>(threads, 1);
+    for(size_t i{0}; i < threads; ++i){ queues.push_back(std::make_unique<queue>()); }
+    for(size_t i{0}; i < threads; ++i){ workers.emplace_back([this, i]{ work(i); }); }
+  }
+
+  work_stealing_pool(const work_stealing_pool&) = delete;
+  work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+  ~work_stealing_pool(){
+    {
+      std::lock_guard<std::mutex> lock(state_mutex);
+      stopping = true;
+    }
+    work_available.notify_all();
+    for(auto& worker : workers){ worker.join(); }
+  }
+};
+
+}
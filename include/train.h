@@ -2,6 +2,11 @@
 #include <iostream>
 #include <utility>
 #include <vector>
+#include <string>
+#include <cassert>
+#include <type_traits>
+
+#include <util.h>
 
 
 namespace train{
@@ -15,6 +20,14 @@ struct sample{
   typename info::latent_vec_t latent;
 };
 
+// sampled sources (ode::data_generator) expose the box initial conditions are drawn from,
+// recorded ones have no such thing.
+template<typename D, typename = void>
+struct has_domain : std::false_type {};
+
+template<typename D>
+struct has_domain<D, std::void_t<decltype(std::declval<D&>().distribution)>> : std::true_type {};
+
 template<typename M, typename D>
 struct trainer{
   using info = typename M::info;
@@ -33,17 +46,23 @@ struct trainer{
     return *this;
   }
 
-  typename info::real_type update_model(){
+  void prepare_domain(){
     if(update_count % epoch_size == 0){
       data.grow_domain();
-      std::cout << std::endl << data.distribution.min() << ", " << data.distribution.max() << std::endl;
+      if constexpr(has_domain<D>::value){
+        std::cout << std::endl << data.distribution.min() << ", " << data.distribution.max() << std::endl;
+      }
     }
-    ++update_count;
-    typename info::latent_vec_t latent; latent.setZero();
-    auto trajectory = data.get_trajectory();
+  }
+
+  // forward and backward over one trajectory, gradients are left accumulated in model.grad.
+  template<typename T>
+  typename info::real_type accumulate_grad(const T& trajectory){
+    typename info::latent_vec_t latent = info::latent_vec_t::Zero(model.dims().latent);
     typename info::real_type t{0.0};
     typename info::real_type err{0.0};
-    for(auto&&[input, exp_out] : trajectory){
+    for(auto&&[input, target] : trajectory){
+      const typename info::out_vec_t exp_out = target;
       const auto[out, next_latent] = model.forward(typename M::backward_t(input, latent));
       const auto gradient = data.gradient(exp_out, out);
       const auto error = data.error(exp_out, out);
@@ -53,7 +72,7 @@ struct trainer{
       t += data.dt();
     }
     
-    typename info::latent_vec_t latent_grad; latent_grad.setZero();
+    typename info::latent_vec_t latent_grad = info::latent_vec_t::Zero(model.dims().latent);
     for(auto iter = history.rbegin(); iter != history.rend(); ++iter){
       //std::cout << iter -> gradient << std::endl;
       const auto grad_info = typename M::forward_t(iter -> gradient, latent_grad);
@@ -62,19 +81,66 @@ struct trainer{
       (void)_; // ignore gradient of loss w.r.t input for now.
       latent_grad = latent_grad_next;
     }
+    history.clear();
+    return err;
+  }
+
+  void apply_grad(){
     model.step_grad(learning_rate);
     model.clear_grad();
-    history.clear();
+  }
+
+  // train on a trajectory supplied by the caller (e.g. one shared between several trainers).
+  template<typename T>
+  typename info::real_type update_model(const T& trajectory){
+    ++update_count;
+    const auto err = accumulate_grad(trajectory);
+    apply_grad();
+    return err;
+  }
+
+  typename info::real_type update_model(){
+    prepare_domain();
+    const auto err = update_model(data.get_trajectory());
+    data.report(err);
     return err;
   }
 
   trainer(M m, D d, size_t epoch=5000) : model(m), data(d), epoch_size{epoch} {
-    static_assert(info::output_dim == D::output_dim);
-    static_assert(info::input_dim == D::input_dim);
+    static_assert(info::output_dim == Eigen::Dynamic || info::output_dim == D::output_dim);
+    static_assert(info::input_dim == Eigen::Dynamic || info::input_dim == D::input_dim);
+    assert((model.dims().output == D::output_dim && model.dims().input == D::input_dim));
     model.set_dt(data.dt());
   }
 };
 
+// the model is written first so checkpoints remain readable by tools which only load weights.
+template<typename M, typename D>
+std::ostream& operator<<(std::ostream& os, const trainer<M, D>& t){
+  os << t.model;
+  os << "trainer\n";
+  os << "learning_rate " << t.learning_rate << '\n';
+  os << "epoch_size " << t.epoch_size << '\n';
+  os << "update_count " << t.update_count << '\n';
+  os << t.data;
+  return os;
+}
+
+template<typename M, typename D>
+std::istream& operator>>(std::istream& is, trainer<M, D>& t){
+  is >> t.model;
+  std::string key{};
+  is >> key; assert((key == "trainer"));
+  is >> key >> t.learning_rate; assert((key == "learning_rate"));
+  is >> key >> t.epoch_size; assert((key == "epoch_size"));
+  is >> key >> t.update_count; assert((key == "update_count"));
+  is >> t.data;
+  t.model.set_dt(t.data.dt());
+  t.model.clear_grad();
+  t.history.clear();
+  return is;
+}
+
 }
 
 
@@ -18,6 +18,30 @@ struct info{
   using out_mat_t = Matrix<T, Output, Latent>;
   using latent_mat_t = Matrix<T, Latent, Latent>;
   using through_mat_t = Matrix<T, Output, Input>;
+  using in_batch_t = Matrix<T, Input, Dynamic>;
+  using out_batch_t = Matrix<T, Output, Dynamic>;
+  using latent_batch_t = Matrix<T, Latent, Dynamic>;
 };
 
+// sizes known only at run time, e.g. read from a saved model.
+template<typename T>
+using dynamic_info = info<T, Dynamic, Dynamic, Dynamic>;
+
+struct dims{
+  Index input;
+  Index output;
+  Index latent;
+
+  bool operator==(const dims& other) const {
+    return input == other.input && output == other.output && latent == other.latent;
+  }
+  bool operator!=(const dims& other) const { return !(*this == other); }
+};
+
+template<typename I>
+dims dims_of(){
+  static_assert(I::input_dim != Dynamic && I::output_dim != Dynamic && I::latent_dim != Dynamic);
+  return dims{I::input_dim, I::output_dim, I::latent_dim};
+}
+
 }
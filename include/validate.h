@@ -0,0 +1,251 @@
+#pragma once
+#include <iostream>
+#include <array>
+#include <vector>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <tuple>
+#include <string>
+#include <cassert>
+
+#include <model.h>
+#include <ode_data_generator.h>
+
+namespace validate{
+
+template<typename W>
+struct snapshot{
+  W w{};
+  size_t update_count{0};
+};
+
+// two weight slots guarded by their own locks. the trainer writes into the slot readers are
+// not pointed at and then flips `front`; it only ever try_locks, so publishing never blocks
+// (a publish is skipped in the rare case a slow reader still holds the back slot).
+template<typename W>
+struct double_buffer{
+  std::array<snapshot<W>, 2> slots{};
+  std::array<std::mutex, 2> locks{};
+  std::atomic<int> front{0};
+  std::atomic<size_t> version{0};
+
+  bool publish(const W& w, const size_t update_count){
+    const int back = 1 - front.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(locks[back], std::try_to_lock);
+    if(!lock.owns_lock()){ return false; }
+    slots[back].w = w;
+    slots[back].update_count = update_count;
+    lock.unlock();
+    front.store(back, std::memory_order_release);
+    version.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+  snapshot<W> read(){
+    const int current = front.load(std::memory_order_acquire);
+    std::lock_guard<std::mutex> lock(locks[current]);
+    return slots[current];
+  }
+};
+
+// fixed, seeded initial conditions so successive evaluations are comparable.
+template<typename Config>
+std::vector<ode::trajectory<Config>> make_set(const Config& c, const size_t count, const typename Config::real_type radius, const unsigned seed=0){
+  std::mt19937 generator{seed};
+  std::uniform_real_distribution<typename Config::real_type> distribution{-radius, radius};
+  std::vector<ode::trajectory<Config>> result{};
+  for(size_t i{0}; i < count; ++i){
+    Eigen::Matrix<typename Config::real_type, Config::dim, 1> X{};
+    X = X.unaryExpr([&](auto){ return distribution(generator); });
+    result.emplace_back(c, X);
+  }
+  return result;
+}
+
+// closed loop: the model's output is fed back as its next input, mean squared error per step.
+template<typename M, typename Config>
+typename M::info::real_type rollout_error(const M& model, const ode::trajectory<Config>& trajectory){
+  using real_type = typename M::info::real_type;
+  typename M::info::latent_vec_t latent = M::info::latent_vec_t::Zero(model.w.m_latent.rows());
+  typename M::info::in_vec_t input = trajectory.X;
+  real_type err{0.0};
+  size_t steps{0};
+  for(auto&&[_, exp_out] : trajectory){
+    (void)_;
+    const auto[out, next_latent] = model.forward(typename M::backward_t(input, latent));
+    err += (out - exp_out).squaredNorm();
+    input = out;
+    latent = next_latent;
+    ++steps;
+  }
+  const real_type result = err / static_cast<real_type>(std::max<size_t>(steps, 1));
+  return std::isfinite(result) ? result : std::numeric_limits<real_type>::infinity();
+}
+
+// what early stopping has seen so far, saved with the checkpoint so a resumed run keeps its
+// best model and patience.
+template<typename I>
+struct progress{
+  snapshot<dyn::weights<I>> best{};
+  typename I::real_type error{std::numeric_limits<typename I::real_type>::infinity()};
+  size_t stale_count{0};
+};
+
+template<typename I>
+std::ostream& operator<<(std::ostream& os, const progress<I>& p){
+  const bool has_best = std::isfinite(p.error);
+  os << "validator " << p.stale_count << ' ' << has_best << '\n';
+  if(has_best){
+    os << "best " << p.error << ' ' << p.best.update_count << '\n';
+    os << p.best.w;
+  }
+  return os;
+}
+
+template<typename I>
+std::istream& operator>>(std::istream& is, progress<I>& p){
+  std::string key{};
+  bool has_best{false};
+  is >> key >> p.stale_count >> has_best; assert((key == "validator"));
+  p.error = std::numeric_limits<typename I::real_type>::infinity();
+  if(has_best){
+    is >> key >> p.error >> p.best.update_count >> std::ws; assert((key == "best"));
+    is >> p.best.w;
+  }
+  return is;
+}
+
+template<typename M, typename Config>
+struct validator{
+  using info = typename M::info;
+  using real_type = typename info::real_type;
+
+  struct result{
+    size_t update_count;
+    real_type error;
+  };
+
+  M model;
+  std::vector<ode::trajectory<Config>> set;
+  size_t threads;
+  size_t patience;
+  real_type min_delta;
+
+  double_buffer<dyn::weights<info>> buffer{};
+
+  std::mutex result_mutex{};
+  std::vector<result> history{};
+  snapshot<dyn::weights<info>> best_snapshot{};
+  real_type best_error{std::numeric_limits<real_type>::infinity()};
+  size_t stale_count{0};
+
+  std::mutex wake_mutex{};
+  std::condition_variable wake{};
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> early_stop{false};
+  std::thread monitor{};
+
+  // called from the training thread, never blocks on validation.
+  bool publish(const M& m, const size_t update_count){
+    const bool published = buffer.publish(m.w, update_count);
+    if(published){ wake.notify_one(); }
+    return published;
+  }
+
+  bool should_stop() const { return early_stop.load(std::memory_order_acquire); }
+
+  std::vector<result> results(){
+    std::lock_guard<std::mutex> lock(result_mutex);
+    return history;
+  }
+
+  std::tuple<snapshot<dyn::weights<info>>, real_type> best(){
+    std::lock_guard<std::mutex> lock(result_mutex);
+    return std::make_tuple(best_snapshot, best_error);
+  }
+
+  progress<info> state(){
+    std::lock_guard<std::mutex> lock(result_mutex);
+    return progress<info>{best_snapshot, best_error, stale_count};
+  }
+
+  void restore(const progress<info>& p){
+    std::lock_guard<std::mutex> lock(result_mutex);
+    best_snapshot = p.best;
+    best_error = p.error;
+    stale_count = p.stale_count;
+    early_stop.store(stale_count >= patience, std::memory_order_release);
+  }
+
+  real_type evaluate(const dyn::weights<info>& w) const {
+    M local = model;
+    local.w = w;
+    const size_t worker_count = std::max<size_t>(1, std::min(threads, set.size()));
+    std::vector<real_type> partial(worker_count, real_type{0.0});
+    std::vector<std::thread> workers{};
+    for(size_t k{0}; k < worker_count; ++k){
+      workers.emplace_back([&, k]{
+        for(size_t i{k}; i < set.size(); i += worker_count){
+          partial[k] += rollout_error(local, set[i]);
+        }
+      });
+    }
+    for(auto& worker : workers){ worker.join(); }
+    real_type sum{0.0};
+    for(const auto& p : partial){ sum += p; }
+    return sum / static_cast<real_type>(std::max<size_t>(set.size(), 1));
+  }
+
+  void run(){
+    size_t seen{0};
+    while(!stopping.load(std::memory_order_acquire)){
+      {
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake.wait_for(lock, std::chrono::milliseconds(50), [&]{
+          return stopping.load() || buffer.version.load(std::memory_order_acquire) != seen;
+        });
+      }
+      const size_t version = buffer.version.load(std::memory_order_acquire);
+      if(stopping.load() || version == seen){ continue; }
+      seen = version;
+
+      const auto snap = buffer.read();
+      const real_type error = evaluate(snap.w);
+
+      std::lock_guard<std::mutex> lock(result_mutex);
+      history.push_back(result{snap.update_count, error});
+      if(error < best_error * (real_type{1.0} - min_delta)){
+        best_error = error;
+        best_snapshot = snap;
+        stale_count = 0;
+      }else if(++stale_count >= patience){
+        early_stop.store(true, std::memory_order_release);
+      }
+    }
+  }
+
+  validator(const M& m, std::vector<ode::trajectory<Config>> set_, size_t threads_=2, size_t patience_=50, real_type min_delta_=0.0) :
+    model{m}, set{std::move(set_)}, threads{threads_}, patience{patience_}, min_delta{min_delta_}
+  {
+    model.clear_grad();
+    monitor = std::thread([this]{ run(); });
+  }
+
+  validator(const validator&) = delete;
+  validator& operator=(const validator&) = delete;
+
+  ~validator(){
+    stopping.store(true, std::memory_order_release);
+    wake.notify_all();
+    monitor.join();
+  }
+};
+
+}
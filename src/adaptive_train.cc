@@ -0,0 +1,65 @@
+#include <iostream>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <ode_data_generator.h>
+#include <adaptive_generator.h>
+#include <van_der_pol.h>
+#include <model.h>
+#include <train.h>
+#include <validate.h>
+
+// trains the same initial model with uniform and with loss driven sampling of initial conditions
+// and reports how many updates each needs to bring the validation error under target.
+// usage: adaptive_train [target] [max_updates]
+int main(int argc, char** argv){
+    const auto config = van_der_pol::config{1.5, 0.01, 500ull};
+    const auto set = validate::make_set(config, 64, 2.0, 7);
+    auto uniform = train::trainer(
+      dyn::model<util::info<double, 2, 2, 6>>::random(0.0),
+      ode::data_generator(config), 500).set_lr(3e-3);
+    auto adaptive = train::trainer(uniform.model, ode::adaptive_generator(config), 500).set_lr(3e-3);
+    uniform.data.generator.seed(1);
+    adaptive.data.generator.seed(1);
+
+    // teacher forced mean squared error per step, the quantity the trainers minimise, on a
+    // fixed set covering the whole domain.
+    const auto evaluate = [&set](const auto& model){
+      using M = std::decay_t<decltype(model)>;
+      double sum{0.0};
+      size_t steps{0};
+      for(const auto& trajectory : set){
+        typename M::info::latent_vec_t latent = M::info::latent_vec_t::Zero(model.dims().latent);
+        for(auto&&[input, target] : trajectory){
+          const auto[out, next_latent] = model.forward(typename M::backward_t(input, latent));
+          sum += (out - target).squaredNorm();
+          latent = next_latent;
+          ++steps;
+        }
+      }
+      return sum / static_cast<double>(std::max<size_t>(steps, 1));
+    };
+
+    const double initial = evaluate(uniform.model);
+    const double target = argc > 1 ? std::stod(argv[1]) : 0.01 * initial;
+    const size_t max_updates = argc > 2 ? std::stoull(argv[2]) : 30000;
+    constexpr size_t eval_rate = 250;
+    std::cout << "initial error: " << initial << " target: " << target << std::endl;
+
+    size_t uniform_hit{0}, adaptive_hit{0};
+    for(size_t i{1}; i <= max_updates && (uniform_hit == 0 || adaptive_hit == 0); ++i){
+      if(uniform_hit == 0){ uniform.update_model(); }
+      if(adaptive_hit == 0){ adaptive.update_model(); }
+      if(i % eval_rate == 0){
+        const double u = uniform_hit == 0 ? evaluate(uniform.model) : target;
+        const double a = adaptive_hit == 0 ? evaluate(adaptive.model) : target;
+        std::cout << i << " uniform: " << u << " adaptive: " << a << std::endl;
+        if(uniform_hit == 0 && u <= target){ uniform_hit = i; }
+        if(adaptive_hit == 0 && a <= target){ adaptive_hit = i; }
+      }
+    }
+
+    const auto show = [](const size_t hit){ return hit == 0 ? std::string("not reached") : std::to_string(hit); };
+    std::cout << "updates to target, uniform: " << show(uniform_hit) << " adaptive: " << show(adaptive_hit) << std::endl;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <limits>
+
+#include <ode_data_generator.h>
+#include <van_der_pol.h>
+#include <lorenz.h>
+#include <model.h>
+#include <train.h>
+#include <dispatch.h>
+#include <validate.h>
+#include <compress.h>
+
+// usage: compress <model_file> <van_der_pol|lorenz> [fine_tune_updates]
+
+template<typename M, typename Config>
+double rollout_seconds(const M& m, const std::vector<ode::trajectory<Config>>& set){
+    using clock = std::chrono::steady_clock;
+    constexpr int repeats = 5;
+    volatile double sink{0.0};
+    const auto begin = clock::now();
+    for(int i{0}; i < repeats; ++i){
+      for(const auto& trajectory : set){ sink = sink + validate::rollout_error(m, trajectory); }
+    }
+    return std::chrono::duration<double>(clock::now() - begin).count() / repeats;
+}
+
+template<typename M, typename Config>
+double set_error(const M& m, const std::vector<ode::trajectory<Config>>& set){
+    double sum{0.0};
+    for(const auto& trajectory : set){ sum += validate::rollout_error(m, trajectory); }
+    return sum / static_cast<double>(set.size());
+}
+
+template<typename Config>
+int run(const std::string& file_name, const Config& config, const size_t fine_tune_updates){
+    std::ifstream load_file(file_name);
+    dyn::model<util::dynamic_info<double>> original(util::dims{0, 0, 0}, config.dt);
+    try{
+      dyn::load_model(load_file, config.dt, [&original](const auto& m){ original = dyn::to_dynamic(m); });
+    }catch(const std::exception& e){
+      std::cerr << file_name << ": " << e.what() << std::endl;
+      return 1;
+    }
+    const util::dims d = original.dims();
+    if(d.input != Config::dim || d.output != Config::dim){
+      std::cerr << "model is " << d.input << " -> " << d.output << ", system has dimension " << Config::dim << std::endl;
+      return 1;
+    }
+
+    const auto calibration = validate::make_set(config, 16, 2.0, 1);
+    const auto evaluation = validate::make_set(config, 16, 2.0, 2);
+    const auto stats = compress::collect(original, calibration);
+    const auto scores = compress::scores(original.w, stats);
+
+    const double base_error = set_error(original, evaluation);
+    const double base_time = rollout_seconds(original, evaluation);
+    std::cout << std::setw(8) << "latent" << std::setw(16) << "error" << std::setw(12) << "time_ms" << std::setw(10) << "speedup" << std::endl;
+    std::cout << std::setw(8) << d.latent << std::setw(16) << base_error << std::setw(12) << 1000.0 * base_time << std::setw(10) << 1.0 << std::endl;
+
+    const Eigen::Index stride = std::max<Eigen::Index>(1, d.latent / 8);
+    for(Eigen::Index keep{d.latent - stride}; keep > 0; keep -= stride){
+      auto compressed = compress::prune(original, stats, compress::select(scores, keep));
+
+      if(fine_tune_updates > 0){
+        auto trainer = train::trainer(compressed, ode::data_generator(config)).set_lr(0.001);
+        // trajectories are drawn here so the domain stays on the calibration box, never grown.
+        trainer.data.distribution = decltype(trainer.data.distribution)(-2.0, 2.0);
+        for(size_t i{0}; i < fine_tune_updates; ++i){ trainer.update_model(trainer.data.get_trajectory()); }
+        compressed = trainer.model;
+      }
+
+      const double error = set_error(compressed, evaluation);
+      const double time = rollout_seconds(compressed, evaluation);
+      std::cout << std::setw(8) << keep << std::setw(16) << error << std::setw(12) << 1000.0 * time << std::setw(10) << base_time / time << std::endl;
+
+      std::ofstream save_file(file_name + ".latent" + std::to_string(keep) + ".txt", std::ios::trunc);
+      save_file.precision(std::numeric_limits<double>::max_digits10);
+      save_file << compressed;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv){
+    if(argc < 3){
+      std::cerr << "usage: " << argv[0] << " <model_file> <van_der_pol|lorenz> [fine_tune_updates]" << std::endl;
+      return 1;
+    }
+    const std::string system = argv[2];
+    const size_t fine_tune_updates = argc > 3 ? std::stoull(argv[3]) : 0;
+    if(system == "van_der_pol"){ return run(argv[1], van_der_pol::config{1.5, 0.01, 5000ull}, fine_tune_updates); }
+    if(system == "lorenz"){ return run(argv[1], lorenz::config{}, fine_tune_updates); }
+    std::cerr << "unknown system " << system << std::endl;
+    return 1;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <limits>
+#include <sys/wait.h>
+#include <ode_data_generator.h>
+#include <van_der_pol.h>
+#include <model.h>
+#include <train.h>
+#include <distributed.h>
+
+// usage:
+//   distributed_train <tcp|shm> <world_size>                  forks world_size local ranks
+//   distributed_train tcp <world_size> <rank> <host_0> ...    one rank of a multi machine run
+//   distributed_train shm <world_size> <rank> <session>       one rank of a same host run
+
+constexpr uint16_t base_port = 47000;
+constexpr size_t steps = 2000;
+constexpr size_t report_rate = 100;
+
+int run(const std::string& kind, size_t world, size_t rank, const std::vector<std::string>& args){
+    std::unique_ptr<dist::transport> comm{};
+    if(kind == "tcp"){
+      std::vector<std::string> hosts = args;
+      hosts.resize(world, "127.0.0.1");
+      comm = std::make_unique<dist::tcp_transport>(rank, world, hosts, base_port);
+    }else{
+      comm = std::make_unique<dist::shm_transport>(rank, world, args.empty() ? std::string("/dsm") : args[0]);
+    }
+
+    auto data = ode::data_generator(van_der_pol::config{1.5, 0.01, 5000ull});
+    auto model = dyn::model<util::info<double, decltype(data)::input_dim, decltype(data)::output_dim, 6>>::random(0.0);
+    auto trainer = dist::data_parallel(train::trainer(model, data).set_lr(0.003), *comm);
+
+    dist::step_stats sum{};
+    for(size_t i{1}; i <= steps; ++i){
+      const auto stats = trainer.step();
+      sum.loss += stats.loss; sum.compute += stats.compute; sum.comm += stats.comm; sum.wall += stats.wall;
+
+      if(rank == 0 && i % report_rate == 0){
+        std::cout <<
+          "step " << i <<
+          " loss " << sum.loss / report_rate <<
+          " compute " << 1000.0 * sum.compute / report_rate << "ms" <<
+          " comm " << 1000.0 * sum.comm / report_rate << "ms" <<
+          " hidden behind data generation " << 100.0 * sum.overlap() << "%" <<
+          " efficiency " << 100.0 * sum.efficiency() << "%" << std::endl;
+        sum = dist::step_stats{};
+      }
+    }
+
+    if(rank == 0){
+      std::ofstream save_file("check_pt/distributed_model.txt", std::ios::trunc);
+      save_file.precision(std::numeric_limits<double>::max_digits10);
+      save_file << trainer.trainer.model;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv){
+    if(argc < 3){
+      std::cerr << "usage: " << argv[0] << " <tcp|shm> <world_size> [rank] [hosts... | session]" << std::endl;
+      return 1;
+    }
+    const std::string kind = argv[1];
+    const size_t world = std::stoull(argv[2]);
+    if(kind != "tcp" && kind != "shm"){
+      std::cerr << "unknown transport " << kind << std::endl;
+      return 1;
+    }
+
+    if(argc > 3){
+      return run(kind, world, std::stoull(argv[3]), std::vector<std::string>(argv + 4, argv + argc));
+    }
+
+    const std::vector<std::string> args = (kind == "shm") ?
+      std::vector<std::string>{"/dsm_" + std::to_string(::getpid())} :
+      std::vector<std::string>{};
+    std::vector<pid_t> children{};
+    for(size_t rank{0}; rank < world; ++rank){
+      const pid_t pid = ::fork();
+      if(pid == 0){ std::_Exit(run(kind, world, rank, args)); }
+      children.push_back(pid);
+    }
+    int failed{0};
+    for(const pid_t pid : children){
+      int status{0};
+      ::waitpid(pid, &status, 0);
+      if(!WIFEXITED(status) || WEXITSTATUS(status) != 0){ ++failed; }
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#include <iostream>
+#include <fstream>
+#include <limits>
+#include <ode_data_generator.h>
+#include <van_der_pol.h>
+#include <ensemble.h>
+
+int main(){
+    const auto config = van_der_pol::config{1.5, 0.01, 5000ull};
+    auto runner = ensemble::runner(config);
+
+    for(const double lr : {0.01, 0.003, 0.001}){
+      for(const size_t epoch : {2000ull, 5000ull}){
+        runner.add(ensemble::make_member<4>(config, ensemble::hyperparameters{lr, 0.0, epoch}));
+        runner.add(ensemble::make_member<6>(config, ensemble::hyperparameters{lr, 0.0, epoch}));
+        runner.add(ensemble::make_member<8>(config, ensemble::hyperparameters{lr, 0.0, epoch}));
+        runner.add(ensemble::make_member<6>(config, ensemble::hyperparameters{lr, 0.5 * config.dt, epoch}));
+      }
+    }
+
+    constexpr int report_rate = 100;
+    constexpr int save_rate = 6000;
+    for(size_t i{1}; runner.live() > 0; ++i){
+      runner.step();
+
+      if(i % report_rate == 0){
+        runner.report(std::cout);
+        std::cout << std::endl;
+      }
+
+      if(i % save_rate == 0){
+        std::ofstream save_file("check_pt/ensemble_best.txt", std::ios::trunc);
+        save_file.precision(std::numeric_limits<double>::max_digits10);
+        runner.best().write(save_file);
+        std::cout << "saved " << runner.best().name << " (load with dt " << runner.best().dt() << ")" << std::endl;
+      }
+    }
+}
@@ -0,0 +1,31 @@
+#include <iostream>
+#include <random>
+#include <cstdlib>
+
+#include <util.h>
+#include <model.h>
+#include <thread_pool.h>
+#include <gradient_check.h>
+
+template<typename M>
+void run(check::report& r, const std::string& label, const M& model, std::mt19937& generator, util::work_stealing_pool& pool){
+  constexpr double h = 1e-4;
+  constexpr double tolerance = 1e-6;
+  check::problem<M> p(model, generator);
+  check::check_directional(r, label, p, generator, h, tolerance);
+  check::check_jacobians(r, label, p, pool, h, tolerance);
+}
+
+int main(){
+  std::srand(17);
+  std::mt19937 generator{17};
+  util::work_stealing_pool pool{};
+  check::report r{};
+
+  run(r, "<4, 5, 6>", dyn::model<util::info<double, 4, 5, 6>>::random(0.25), generator, pool);
+  run(r, "<3, 3, 16>", dyn::model<util::info<double, 3, 3, 16>>::random(0.1), generator, pool);
+  run(r, "dynamic {5, 4, 200}", dyn::model<util::dynamic_info<double>>::random(util::dims{5, 4, 200}, 0.05), generator, pool);
+
+  std::cout << (r.passed() ? "all gradient checks passed" : "gradient check FAILED") << std::endl;
+  return r.passed() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
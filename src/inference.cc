@@ -1,24 +1,40 @@
 #include <iostream>
 #include <fstream>
+#include <string>
 
 #include <util.h>
 #include <model.h>
+#include <dispatch.h>
 
 
 int main(){
     std::string file_name; std::cout << "file_name :: "; std::cin >> file_name;
+    double dt{0.01}; std::cout << "dt :: "; std::cin >> dt;
     std::fstream load_file(file_name);
-    using M = dyn::model<util::info<double, 2, 2, 6>>;
-    M m{0.01}; load_file >> m;
-    std::cout << m << std::endl;
-    M::info::latent_vec_t latent{}; latent.setZero();
-    M::info::in_vec_t input{}; input(0) = input(1) = 0.5;
-    std::fstream csv_output("output.csv", std::ios::app);
-    csv_output << "x, y" << std::endl;
-    for(size_t i(0); i < 10000; ++i){
-        const auto [next_input, next_latent] = m.forward(M::backward_t(input, latent));
-        input = next_input;
-        latent = next_latent;
-        csv_output << input(0) << ", " << input(1) << std::endl;
+    bool fixed{false};
+    try{
+      fixed = dyn::load_model(load_file, dt, [](const auto& m){
+          using M = std::decay_t<decltype(m)>;
+          std::cout << m << std::endl;
+          typename M::info::latent_vec_t latent = M::info::latent_vec_t::Zero(m.dims().latent);
+          typename M::info::in_vec_t input = M::info::in_vec_t::Constant(m.dims().input, 0.5);
+          std::fstream csv_output("output.csv", std::ios::app);
+          const auto column = [](const Eigen::Index i){
+              return i < 3 ? std::string(1, "xyz"[i]) : "x" + std::to_string(i);
+          };
+          for(Eigen::Index i(0); i < input.rows(); ++i){ csv_output << (i ? ", " : "") << column(i); }
+          csv_output << std::endl;
+          for(size_t i(0); i < 10000; ++i){
+              const auto [next_input, next_latent] = m.forward(typename M::backward_t(input, latent));
+              input = next_input;
+              latent = next_latent;
+              for(Eigen::Index j(0); j < input.rows(); ++j){ csv_output << (j ? ", " : "") << input(j); }
+              csv_output << std::endl;
+          }
+      });
+    }catch(const std::exception& e){
+      std::cerr << file_name << ": " << e.what() << std::endl;
+      return 1;
     }
+    std::cout << (fixed ? "fixed size" : "dynamic size") << " model" << std::endl;
 }
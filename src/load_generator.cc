@@ -0,0 +1,46 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include <serve.h>
+
+// usage: load_generator [socket_path] [clients] [steps_per_client]
+int main(int argc, char** argv){
+    using clock = std::chrono::steady_clock;
+    const std::string socket_path = argc > 1 ? argv[1] : "/tmp/dyn_model.sock";
+    const size_t clients = argc > 2 ? std::stoull(argv[2]) : 64;
+    const size_t steps = argc > 3 ? std::stoull(argv[3]) : 1000;
+
+    std::vector<std::vector<double>> latencies(clients);
+    std::vector<std::thread> threads{};
+    const auto start = clock::now();
+    for(size_t k{0}; k < clients; ++k){
+      threads.emplace_back([&, k]{
+        serve::client c(socket_path);
+        std::vector<double> input(c.dims.input_dim, 0.5);
+        latencies[k].reserve(steps);
+        for(size_t i{0}; i < steps; ++i){
+          const auto begin = clock::now();
+          const auto output = c.step(input);
+          latencies[k].push_back(std::chrono::duration<double, std::micro>(clock::now() - begin).count());
+          std::copy_n(output.begin(), std::min(output.size(), input.size()), input.begin());
+        }
+      });
+    }
+    for(auto& t : threads){ t.join(); }
+    const double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::vector<double> all{};
+    for(const auto& l : latencies){ all.insert(all.end(), l.begin(), l.end()); }
+    std::sort(all.begin(), all.end());
+    const auto percentile = [&all](const double p){
+      return all.empty() ? 0.0 : all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+    };
+
+    std::cout << "clients " << clients << ", steps " << all.size() << std::endl;
+    std::cout << "throughput " << static_cast<double>(all.size()) / elapsed << " steps/s" << std::endl;
+    std::cout << "latency p50 " << percentile(0.50) << "us, p99 " << percentile(0.99) << "us, max " << (all.empty() ? 0.0 : all.back()) << "us" << std::endl;
+}
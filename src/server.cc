@@ -0,0 +1,33 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+
+#include <util.h>
+#include <model.h>
+#include <dispatch.h>
+#include <serve.h>
+
+// usage: server <model_file> [socket_path] [window_us] [max_batch] [dt]
+int main(int argc, char** argv){
+    if(argc < 2){
+      std::cerr << "usage: " << argv[0] << " <model_file> [socket_path] [window_us] [max_batch] [dt]" << std::endl;
+      return 1;
+    }
+    const std::string socket_path = argc > 2 ? argv[2] : "/tmp/dyn_model.sock";
+    const auto window = std::chrono::microseconds(argc > 3 ? std::stoll(argv[3]) : 200);
+    const size_t max_batch = argc > 4 ? std::stoull(argv[4]) : 256;
+    const double dt = argc > 5 ? std::stod(argv[5]) : 0.01;
+
+    std::fstream load_file(argv[1]);
+    try{
+      dyn::load_model(load_file, dt, [&](const auto& m){
+        serve::server<std::decay_t<decltype(m)>> s(m, socket_path, window, max_batch);
+        std::cout << "serving " << argv[1] << " on " << socket_path << std::endl;
+        s.run();
+      });
+    }catch(const std::exception& e){
+      std::cerr << argv[1] << ": " << e.what() << std::endl;
+      return 1;
+    }
+}
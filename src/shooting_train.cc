@@ -0,0 +1,32 @@
+#include <iostream>
+#include <fstream>
+#include <limits>
+#include <ode_data_generator.h>
+#include <lorenz.h>
+#include <model.h>
+#include <train.h>
+#include <shooting.h>
+
+int main(){
+    auto data = ode::data_generator(lorenz::config{10.0, 28.0, 8.0/3.0, 0.001, 5000ull});
+    auto model = dyn::model<util::info<double, decltype(data)::input_dim, decltype(data)::output_dim, 8>>::random(0.0);
+    auto trainer = train::multiple_shooting(train::trainer(model, data).set_lr(1e-5), 16, 1.0, 0.25, 4);
+    constexpr int sample_rate = 100;
+    constexpr int save_rate = 6000;
+    double sum{0.0};
+    for(size_t i{0};;++i){
+      sum += trainer.update_model();
+
+      if(i !=0 && i % sample_rate == 0){
+        std::cout << "\r" << std::flush << sum / static_cast<decltype(sum)>(sample_rate);
+        sum = 0.0;
+      }
+
+      if(i !=0 && i % save_rate == 0){
+        std::ofstream save_file("check_pt/shooting_model_" + std::to_string(i) + ".txt", std::ios::trunc);
+        save_file.precision(std::numeric_limits<double>::max_digits10);
+        save_file << trainer.base.model;
+      }
+
+    }
+}
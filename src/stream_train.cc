@@ -0,0 +1,52 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <limits>
+#include <ode_data_generator.h>
+#include <van_der_pol.h>
+#include <model.h>
+#include <train.h>
+#include <checkpoint.h>
+#include <stream.h>
+
+// trains on a recorded 2d state series (one state per record, .csv or raw doubles).
+// without arguments a van der pol series is recorded to van_der_pol_series.csv first.
+// usage: stream_train [series] [dt]
+int main(int argc, char** argv){
+    std::string path = argc > 1 ? argv[1] : "van_der_pol_series.csv";
+    const double dt = argc > 2 ? std::stod(argv[2]) : 0.01;
+    if(argc <= 1){
+      std::ofstream out(path, std::ios::trunc);
+      out.precision(std::numeric_limits<double>::max_digits10);
+      out << "# x, y\n";
+      const auto recording = ode::trajectory(van_der_pol::config{1.5, dt, 200000ull}, Eigen::Vector2d(0.5, 0.0));
+      for(auto&&[state, _] : recording){
+        (void)_;
+        out << state(0) << ", " << state(1) << '\n';
+      }
+    }
+
+    auto data = stream::series<double, 2, 2>(path, dt, 500, 250);
+    auto model = dyn::model<util::info<double, decltype(data)::input_dim, decltype(data)::output_dim, 6>>::random(0.0);
+    auto trainer = train::trainer(model, data).set_lr(1e-3);
+    auto checkpoints = checkpoint::manager<decltype(trainer)>("check_pt", "stream", 5);
+    if(checkpoints.load_latest(trainer)){
+      std::cout << "resumed at update " << trainer.update_count << " (pass " << trainer.data.epoch << ", record " << trainer.data.row << ")" << std::endl;
+    }
+    constexpr int sample_rate = 100;
+    constexpr int save_rate = 6000;
+    double sum{0.0};
+    for(size_t i{trainer.update_count};;++i){
+      sum += trainer.update_model();
+
+      if(i !=0 && i % sample_rate == 0){
+        std::cout << "\r" << std::flush << sum / static_cast<decltype(sum)>(sample_rate) << " (pass " << trainer.data.epoch << ")";
+        sum = 0.0;
+      }
+
+      if(i !=0 && i % save_rate == 0){
+        checkpoints.save(trainer);
+      }
+
+    }
+}
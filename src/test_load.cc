@@ -3,10 +3,18 @@
 #include <van_der_pol.h>
 #include <model.h>
 #include <train.h>
+#include <dispatch.h>
 
 int main(){
-    auto model = dyn::model<util::info<double, 2, 2, 16>>(0.0);
     std::ifstream save_file("check_pt/model_save.txt");
-    save_file >> model;
-    std::cout << std::endl << model << std::endl;
+    try{
+      dyn::load_model(save_file, 0.0, [](const auto& model){
+        const auto d = model.dims();
+        std::cout << std::endl << d.input << " -> " << d.output << ", latent " << d.latent << std::endl;
+        std::cout << std::endl << model << std::endl;
+      });
+    }catch(const std::exception& e){
+      std::cerr << "check_pt/model_save.txt: " << e.what() << std::endl;
+      return 1;
+    }
 }
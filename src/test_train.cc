@@ -1,19 +1,33 @@
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <cmath>
 #include <ode_data_generator.h>
 #include <van_der_pol.h>
 #include <lorenz.h>
 #include <model.h>
 #include <train.h>
+#include <checkpoint.h>
+#include <validate.h>
 
 int main(){
-    auto data = ode::data_generator(van_der_pol::config{1.5, 0.01, 5000ull});
+    const auto config = van_der_pol::config{1.5, 0.01, 5000ull};
+    auto data = ode::data_generator(config);
     auto model = dyn::model<util::info<double, decltype(data)::input_dim, decltype(data)::output_dim, 6>>::random(0.0);
     auto trainer = train::trainer(model, data).set_lr(0.01);
+    auto validation = validate::validator(trainer.model, validate::make_set(config, 16, 2.0), 2, 50);
+    using state_t = checkpoint::bundle<decltype(trainer), decltype(validation.state())>;
+    auto checkpoints = checkpoint::manager<state_t>("check_pt", "trainer", 5);
+    if(auto resumed = state_t(trainer, validation.state()); checkpoints.load_latest(resumed)){
+      trainer = resumed.primary;
+      validation.restore(resumed.extra);
+      std::cout << "resumed at update " << trainer.update_count << std::endl;
+    }
     constexpr int sample_rate = 100;
+    constexpr int validation_rate = 1000;
     constexpr int save_rate = 6000;
     double sum{0.0};
-    for(size_t i{0};;++i){
+    for(size_t i{trainer.update_count}; !validation.should_stop(); ++i){
       sum += trainer.update_model();
 
       if(i !=0 && i % sample_rate == 0){
@@ -21,10 +35,25 @@ int main(){
         sum = 0.0;
       }
 
+      if(i !=0 && i % validation_rate == 0){
+        validation.publish(trainer.model, trainer.update_count);
+        const auto[best, best_error] = validation.best();
+        std::cout << " (validation best: " << best_error << " @ " << best.update_count << ")" << std::flush;
+      }
+
       if(i !=0 && i % save_rate == 0){
-        std::fstream save_file("check_pt/model_save_" + std::to_string(i) + ".txt", std::ios::app);
-        save_file << trainer.model;
+        checkpoints.save(state_t(trainer, validation.state()));
       }
 
     }
+
+    const auto[best, best_error] = validation.best();
+    if(!std::isfinite(best_error)){
+      std::cout << std::endl << "early stop, no finite validation error" << std::endl;
+      return 1;
+    }
+    std::cout << std::endl << "early stop, best validation error " << best_error << " @ " << best.update_count << std::endl;
+    std::ofstream best_file("check_pt/best_model.txt", std::ios::trunc);
+    best_file.precision(std::numeric_limits<double>::max_digits10);
+    best_file << best.w;
 }